@@ -0,0 +1,197 @@
+/*
+ * Dakota Memory Allocation
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+
+/*
+ * Every block starts with header which keeps block size and owner, thus
+ * free needs no size and counters stay exact. Header takes the minimal
+ * room that keeps the block aligned as malloc does, 16 bytes on LP64.
+ */
+union head {
+	struct {
+		size_t size;
+		int id;
+	};
+	alignas (max_align_t) char align[1];
+};
+
+/*
+ * Counters are atomic, thus blocks may be allocated and freed by several
+ * threads at once
+ */
+struct pool {
+	const char *name;
+	atomic_size_t live, peak, count;
+};
+
+static struct pool pool[ALLOC_COUNT] = {
+	[ALLOC_BITMAP]	= { "bitmap"	},
+	[ALLOC_TILE]	= { "tile"	},
+	[ALLOC_CHIPLET]	= { "chiplet"	},
+	[ALLOC_MODEL]	= { "model"	},
+	[ALLOC_SYMBOL]	= { "symbol"	},
+	[ALLOC_ARRAY]	= { "array"	},
+	[ALLOC_ARENA]	= { "arena"	},
+	[ALLOC_INTERN]	= { "intern"	},
+};
+
+static atomic_size_t live, peak;
+
+static void *std_alloc (void *cookie, void *p, size_t old, size_t size)
+{
+	(void) cookie;
+	(void) old;
+
+	if (size != 0)
+		return realloc (p, size);
+
+	free (p);
+	return NULL;
+}
+
+static dakota_alloc_fn *alloc_fn = std_alloc;
+static void *alloc_cookie;
+
+void dakota_set_allocator (dakota_alloc_fn *fn, void *cookie)
+{
+	alloc_fn     = fn == NULL ? std_alloc : fn;
+	alloc_cookie = cookie;
+}
+
+static void update_peak (atomic_size_t *peak, size_t live)
+{
+	size_t old = atomic_load_explicit (peak, memory_order_relaxed);
+
+	while (old < live &&
+	       !atomic_compare_exchange_weak_explicit (peak, &old, live,
+						       memory_order_relaxed,
+						       memory_order_relaxed))
+		/* retry with the current peak */;
+}
+
+static size_t add (atomic_size_t *o, size_t size)
+{
+	return atomic_fetch_add_explicit (o, size, memory_order_relaxed) + size;
+}
+
+static void charge (int id, size_t size)
+{
+	struct pool *p = pool + id;
+
+	add (&p->count, 1);
+	update_peak (&p->peak, add (&p->live, size));
+	update_peak (&peak, add (&live, size));
+}
+
+static void release (int id, size_t size)
+{
+	atomic_fetch_sub_explicit (&pool[id].live, size, memory_order_relaxed);
+	atomic_fetch_sub_explicit (&live, size, memory_order_relaxed);
+}
+
+void *dakota_realloc (int id, void *p, size_t size)
+{
+	union head *h = p == NULL ? NULL : (union head *) p - 1;
+	size_t old = h == NULL ? 0 : sizeof (*h) + h->size;
+
+	if (size > SIZE_MAX - sizeof (*h)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if ((p = alloc_fn (alloc_cookie, h, old, sizeof (*h) + size)) == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	if (h != NULL)
+		release (((union head *) p)->id, ((union head *) p)->size);
+
+	h = p;
+	h->size = size;
+	h->id   = id;
+
+	charge (id, size);
+	return h + 1;
+}
+
+void *dakota_alloc (int id, size_t size)
+{
+	return dakota_realloc (id, NULL, size);
+}
+
+void *dakota_zalloc (int id, size_t size)
+{
+	void *p;
+
+	if ((p = dakota_alloc (id, size)) != NULL)
+		memset (p, 0, size);
+
+	return p;
+}
+
+void dakota_free (void *p)
+{
+	union head *h;
+
+	if (p == NULL)
+		return;
+
+	h = (union head *) p - 1;
+
+	release (h->id, h->size);
+	alloc_fn (alloc_cookie, h, sizeof (*h) + h->size, 0);
+}
+
+char *dakota_strdup (int id, const char *s)
+{
+	size_t size = strlen (s) + 1;
+	char *p;
+
+	if ((p = dakota_alloc (id, size)) != NULL)
+		memcpy (p, s, size);
+
+	return p;
+}
+
+size_t dakota_alloc_live (int id)
+{
+	return id < ALLOC_COUNT ? pool[id].live : live;
+}
+
+size_t dakota_alloc_peak (int id)
+{
+	return id < ALLOC_COUNT ? pool[id].peak : peak;
+}
+
+int dakota_alloc_report (FILE *out)
+{
+	const struct pool *p;
+	size_t i;
+	int ok;
+
+	ok = fprintf (out, "%-8s %14s %14s %12s\n", "memory", "live, bytes",
+		      "peak, bytes", "allocs") > 0;
+
+	for (i = 0, p = pool; i < ALLOC_COUNT; ++i, ++p)
+		ok &= fprintf (out, "%-8s %14zu %14zu %12zu\n", p->name,
+			       atomic_load (&p->live), atomic_load (&p->peak),
+			       atomic_load (&p->count)) > 0;
+
+	ok &= fprintf (out, "%-8s %14zu %14zu\n", "total",
+		       atomic_load (&live), atomic_load (&peak)) > 0;
+	return ok;
+}
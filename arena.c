@@ -0,0 +1,134 @@
+/*
+ * Dakota Memory Arena
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/arena.h>
+
+#define ARENA_CHUNK  (64 * 1024)
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;
+	max_align_t data[];
+};
+
+void arena_init (struct arena *o)
+{
+	o->head  = NULL;
+	o->chunk = NULL;
+	o->pos   = NULL;
+	o->end   = NULL;
+}
+
+void arena_fini (struct arena *o)
+{
+	struct arena_chunk *c, *next;
+
+	for (c = o->head; c != NULL; c = next) {
+		next = c->next;
+		dakota_free (c);
+	}
+
+	arena_init (o);
+}
+
+static void arena_enter (struct arena *o, struct arena_chunk *c)
+{
+	o->chunk = c;
+	o->pos   = (char *) c->data;
+	o->end   = o->pos + c->size;
+}
+
+void arena_reset (struct arena *o)
+{
+	if (o->head != NULL)
+		arena_enter (o, o->head);
+}
+
+/*
+ * Move to the next kept chunk if it is large enough, or insert new chunk
+ * after the current one otherwise
+ */
+static int arena_grow (struct arena *o, size_t size)
+{
+	struct arena_chunk *c = o->chunk == NULL ? o->head : o->chunk->next;
+
+	if (c != NULL && c->size >= size) {
+		arena_enter (o, c);
+		return 1;
+	}
+
+	size = size < ARENA_CHUNK ? ARENA_CHUNK : size;
+
+	if (size > SIZE_MAX - sizeof (*c)) {
+		errno = ENOMEM;
+		return 0;
+	}
+
+	if ((c = dakota_alloc (ALLOC_ARENA, sizeof (*c) + size)) == NULL)
+		return 0;
+
+	c->size = size;
+
+	if (o->chunk == NULL) {
+		c->next = o->head;
+		o->head = c;
+	}
+	else {
+		c->next = o->chunk->next;
+		o->chunk->next = c;
+	}
+
+	arena_enter (o, c);
+	return 1;
+}
+
+void *arena_alloc (struct arena *o, size_t size)
+{
+	const size_t align = sizeof (max_align_t);
+	void *p;
+
+	if (size > SIZE_MAX - align) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	size = size == 0 ? align : (size + align - 1) & ~(align - 1);
+
+	if ((size_t) (o->end - o->pos) < size && !arena_grow (o, size))
+		return NULL;
+
+	p = o->pos;
+	o->pos += size;
+	return p;
+}
+
+void *arena_zalloc (struct arena *o, size_t size)
+{
+	void *p;
+
+	if ((p = arena_alloc (o, size)) != NULL)
+		memset (p, 0, size);
+
+	return p;
+}
+
+char *arena_strdup (struct arena *o, const char *s)
+{
+	size_t size = strlen (s) + 1;
+	char *p;
+
+	if ((p = arena_alloc (o, size)) != NULL)
+		memcpy (p, s, size);
+
+	return p;
+}
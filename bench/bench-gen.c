@@ -0,0 +1,404 @@
+/*
+ * Dakota Synthetic Design Generator
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dakota/cache.h>
+#include <dakota/chip-bits.h>
+#include <dakota/string.h>
+
+#include "bench.h"
+
+struct conf {
+	size_t tiles;		/* tiles in design */
+	size_t arcs;		/* arcs per tile */
+	int words, enums;	/* percent of tiles with word or enum */
+	size_t cells;		/* cells in model */
+	size_t parts, blits;	/* symbol library parts and blits on sheets */
+};
+
+static int chance (int percent)
+{
+	return rand () % 100 < percent;
+}
+
+/*
+ * Store count random bits, the first one or two bits may be given
+ */
+static int store_bits (struct cmdb *db, const char *key, size_t count,
+		       const unsigned *given, size_t ngiven)
+{
+	unsigned bits[8];
+	size_t i;
+	char *value;
+	int ok;
+
+	for (i = 0; i < count; ++i) {
+		bits[i] = i < ngiven ? given[i] :
+			  chip_bit_make (rand () % BENCH_FRAMES,
+					 rand () % BENCH_BITS, chance (20));
+
+		if (i + 1 < count)
+			bits[i] |= 0x8000;  /* not the last one */
+	}
+
+	if ((value = chip_bits_string (bits)) == NULL)
+		return 0;
+
+	ok = cmdb_store (db, key, value);
+	free (value);
+	return ok;
+}
+
+static int gen_type (struct cmdb *db, const char *type)
+{
+	const unsigned corner[2] = {
+		chip_bit_make (0, 0, 1),
+		chip_bit_make (BENCH_FRAMES - 1, BENCH_BITS - 1, 1),
+	};
+	char name[16], key[16];
+	size_t i, j;
+
+	if (!cmdb_level (db, "tile :", type, NULL) ||
+	    !store_bits (db, "raw", 4, corner, 2))
+		return 0;
+
+	for (i = 0; i < BENCH_MUXES; ++i) {
+		snprintf (name, sizeof (name), "M%zu", i);
+
+		if (!cmdb_level (db, "tile :", type, "mux :", name, NULL))
+			return 0;
+
+		for (j = 0; j < BENCH_SOURCES; ++j) {
+			snprintf (key, sizeof (key), "S%zu", j);
+
+			if (!store_bits (db, key, 2, NULL, 0))
+				return 0;
+		}
+	}
+
+	for (i = 0; i < BENCH_WORDS; ++i) {
+		snprintf (name, sizeof (name), "W%zu", i);
+
+		if (!cmdb_level (db, "tile :", type, "word :", name, NULL))
+			return 0;
+
+		for (j = 0; j < BENCH_WORD_SIZE; ++j) {
+			snprintf (key, sizeof (key), "%zu", j);
+
+			if (!store_bits (db, key, 1, NULL, 0))
+				return 0;
+		}
+	}
+
+	for (i = 0; i < BENCH_ENUMS; ++i) {
+		snprintf (name, sizeof (name), "E%zu", i);
+
+		if (!cmdb_level (db, "tile :", type, "enum :", name, NULL))
+			return 0;
+
+		for (j = 0; j < BENCH_VALUES; ++j) {
+			snprintf (key, sizeof (key), "V%zu", j);
+
+			if (!store_bits (db, key, 3, NULL, 0))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int gen_tiles (const char *family)
+{
+	struct cmdb *db;
+	char type[16];
+	int i, ok = 1;
+
+	if ((db = dakota_open_tiles (family, "rwx")) == NULL)
+		return 0;
+
+	for (i = 0; ok && i < BENCH_TYPES; ++i) {
+		snprintf (type, sizeof (type), "T%d", i);
+		ok = gen_type (db, type);
+	}
+
+	ok &= dakota_close (db);
+	return ok;
+}
+
+static const char *tile_name (size_t side, size_t i)
+{
+	static char name[64];
+
+	snprintf (name, sizeof (name), "R%zuC%zu:T%zu", i / side, i % side,
+		  (i * 7 + i / side) % BENCH_TYPES);
+	return name;
+}
+
+static int gen_grid (const char *family, const char *device, size_t side)
+{
+	struct cmdb *db;
+	size_t i;
+	char x[24], y[24];
+	int ok = 1;
+
+	if ((db = dakota_open_grid (family, device, "rwx")) == NULL)
+		return 0;
+
+	for (i = 0; ok && i < side * side; ++i) {
+		snprintf (x, sizeof (x), "%zu", (i % side) * BENCH_FRAMES);
+		snprintf (y, sizeof (y), "%zu", (i / side) * BENCH_BITS);
+
+		ok = cmdb_level (db, "tile :", tile_name (side, i), NULL) &&
+		     cmdb_store (db, "x", x) &&
+		     cmdb_store (db, "y", y);
+	}
+
+	ok &= dakota_close (db);
+	return ok;
+}
+
+static void gen_word (FILE *out)
+{
+	size_t i;
+
+	fprintf (out, "word: W%d ", rand () % BENCH_WORDS);
+
+	for (i = 0; i < BENCH_WORD_SIZE; ++i)
+		fputc ('0' + rand () % 2, out);
+
+	fputc ('\n', out);
+}
+
+static int
+gen_design (const char *path, const char *device, const struct conf *c,
+	    size_t side)
+{
+	FILE *out;
+	size_t i, j;
+	int ok;
+
+	if ((out = fopen (path, "w")) == NULL)
+		return 0;
+
+	fprintf (out, ".device %s\n\n.comment synthetic design\n\n", device);
+
+	for (i = 0; i < c->tiles; ++i) {
+		fprintf (out, ".tile %s\n", tile_name (side, i));
+
+		for (j = 0; j < c->arcs; ++j)
+			fprintf (out, "arc: M%d S%d\n", rand () % BENCH_MUXES,
+				 rand () % BENCH_SOURCES);
+
+		if (chance (c->words))
+			gen_word (out);
+
+		if (chance (c->enums))
+			fprintf (out, "enum: E%d V%d\n", rand () % BENCH_ENUMS,
+				 rand () % BENCH_VALUES);
+
+		fputc ('\n', out);
+	}
+
+	ok = !ferror (out);
+	ok &= fclose (out) == 0;
+	return ok;
+}
+
+/*
+ * Model with LUT4 cells driven by inputs or previous cells, every fourth
+ * cell is a two-input table instead
+ */
+static int gen_model (const char *path, size_t cells)
+{
+	const size_t ninputs = 64, noutputs = 16;
+	FILE *out;
+	size_t i, j, k;
+	int ok;
+
+	if ((out = fopen (path, "w")) == NULL)
+		return 0;
+
+	fprintf (out, ".model bench\n.inputs");
+
+	for (i = 0; i < ninputs; ++i)
+		fprintf (out, " I%zu", i);
+
+	fprintf (out, "\n.outputs");
+
+	for (i = 0; i < noutputs; ++i)
+		fprintf (out, " O%zu", i);
+
+	fprintf (out, "\n\n");
+
+	for (i = 0; i < cells; ++i) {
+		fprintf (out, i % 4 == 3 ? ".names" : ".subckt lut4");
+
+		for (j = 0; j < (i % 4 == 3 ? 2 : 4); ++j) {
+			k = rand () % (ninputs + i);
+
+			if (i % 4 != 3)
+				fprintf (out, " %c=", 'A' + (int) j);
+			else
+				fputc (' ', out);
+
+			if (k < ninputs)
+				fprintf (out, "I%zu", k);
+			else
+				fprintf (out, "N%zu", k - ninputs);
+		}
+
+		if (i % 4 == 3)
+			fprintf (out, " N%zu\n11 1\n", i);
+		else
+			fprintf (out, " Y=N%zu\n.param INIT %04x\n", i,
+				 rand () & 0xffff);
+	}
+
+	for (i = 0; i < noutputs; ++i)
+		fprintf (out, ".names N%zu O%zu\n1 1\n",
+			 cells - 1 - i % cells, i);
+
+	fprintf (out, "\n.model lut4\n.inputs A B C D\n.outputs Y\n"
+		      ".names A B C D Y\n1111 1\n");
+
+	ok = !ferror (out);
+	ok &= fclose (out) == 0;
+	return ok;
+}
+
+/*
+ * Symbol library of parts named after gaf/lib symbols, and sheets of
+ * pages with blits of random parts: every blit is resolved from a page
+ * through its sheet up to the library
+ */
+static const char *part_base[] = {
+	"sram-64K-16-1", "sram-64K-8-1", "ttl-244-1", "ttl-245-1",
+	"ttl-373-1", "ttl-541-1", "ttl-573-1", "ttl-574-1",
+};
+
+#define PART_BASES  (sizeof (part_base) / sizeof (part_base[0]))
+
+static void gen_part (FILE *out, size_t i)
+{
+	const int h = 800 + (i % PART_BASES) * 200;
+
+	fprintf (out, "tile %s.%zu\n", part_base[i % PART_BASES], i);
+	fprintf (out, "move 0 0\nline 600 0\nline 600 %d\nline 0 %d\n"
+		      "line 0 0\n", h, h);
+	fprintf (out, "mark 0 200 A\nmark 600 200 Y\n");
+	fprintf (out, "text 300 %d c %s\nend\n", h + 100,
+		 part_base[i % PART_BASES]);
+}
+
+static int gen_symbols (const char *path, const struct conf *c)
+{
+	const size_t per_page = 500, per_sheet = 10;
+	FILE *out;
+	size_t i, j, k;
+	int ok;
+
+	if ((out = fopen (path, "w")) == NULL)
+		return 0;
+
+	for (i = 0; i < c->parts; ++i)
+		gen_part (out, i);
+
+	for (i = 0; i * per_page < c->blits; ++i) {
+		if (i % per_sheet == 0)
+			fprintf (out, "%stile sheet-%zu\n", i > 0 ? "end\n" : "",
+				 i / per_sheet);
+
+		fprintf (out, "tile page-%zu\n", i);
+
+		for (j = 0; j < per_page && i * per_page + j < c->blits; ++j) {
+			k = rand () % c->parts;
+			fprintf (out, "blit %zu %zu %d %s.%zu\n", j % 25 * 1000,
+				 j / 25 * 1500, rand () % 4,
+				 part_base[k % PART_BASES], k);
+		}
+
+		fprintf (out, "end\n");
+	}
+
+	if (i > 0)
+		fprintf (out, "end\n");
+
+	ok = !ferror (out);
+	ok &= fclose (out) == 0;
+	return ok;
+}
+
+static void usage (void)
+{
+	errx (0, "\n\t"
+		 "bench-gen [-s <seed>] [-t <tiles>] [-a <arcs>] "
+		 "[-w <word%%>] [-e <enum%%>] [-c <cells>]\n\t\t"
+		 "[-y <parts>] [-b <blits>] <family> <device> <prefix>");
+}
+
+int main (int argc, char *argv[])
+{
+	struct conf c = { 10000, 8, 50, 50, 20000, 5000, 50000 };
+	size_t side;
+	char *path;
+	int opt;
+
+	srand (1);
+
+	while ((opt = getopt (argc, argv, "s:t:a:w:e:c:y:b:")) != -1)
+		switch (opt) {
+		case 's':  srand (atoi (optarg));	break;
+		case 't':  c.tiles = atol (optarg);	break;
+		case 'a':  c.arcs  = atol (optarg);	break;
+		case 'w':  c.words = atoi (optarg);	break;
+		case 'e':  c.enums = atoi (optarg);	break;
+		case 'c':  c.cells = atol (optarg);	break;
+		case 'y':  c.parts = atol (optarg);	break;
+		case 'b':  c.blits = atol (optarg);	break;
+		default:   usage ();
+		}
+
+	if (argc - optind != 3 || c.tiles == 0 || c.cells < 16 ||
+	    c.parts == 0)
+		usage ();
+
+	argv += optind;
+
+	for (side = sqrt (c.tiles); side * side < c.tiles; ++side)
+		/* round up to the whole grid */;
+
+	if (!gen_tiles (argv[0]))
+		err (1, "cannot generate tile database");
+
+	if (!gen_grid (argv[0], argv[1], side))
+		err (1, "cannot generate grid database");
+
+	if ((path = make_string ("%s.trellis", argv[2])) == NULL ||
+	    !gen_design (path, argv[1], &c, side))
+		err (1, "cannot generate design");
+
+	free (path);
+
+	if ((path = make_string ("%s.blif", argv[2])) == NULL ||
+	    !gen_model (path, c.cells))
+		err (1, "cannot generate model");
+
+	free (path);
+
+	if ((path = make_string ("%s.symbols", argv[2])) == NULL ||
+	    !gen_symbols (path, &c))
+		err (1, "cannot generate symbols");
+
+	free (path);
+	return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Dakota Benchmark Conventions
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_BENCH_H
+#define DAKOTA_BENCH_H  1
+
+/*
+ * Synthetic tile database layout shared by generator and benchmarks:
+ * every tile type T<n> is FRAMES × BITS bits in size and has MUXES muxes
+ * M<n> with SOURCES sources S<n>, WORDS words W<n> of WORD_SIZE bits and
+ * ENUMS enums E<n> with VALUES values V<n>.
+ */
+#define BENCH_TYPES	4
+#define BENCH_FRAMES	48
+#define BENCH_BITS	94
+
+#define BENCH_MUXES	64
+#define BENCH_SOURCES	8
+#define BENCH_WORDS	8
+#define BENCH_WORD_SIZE	16
+#define BENCH_ENUMS	8
+#define BENCH_VALUES	4
+
+#endif  /* DAKOTA_BENCH_H */
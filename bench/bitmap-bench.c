@@ -0,0 +1,481 @@
+/*
+ * Dakota Bitmap Benchmark and Differential Test
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dakota/bitmap.h>
+
+#include "bitmap-pool.h"
+
+/*
+ * Blit implementations under test, the first one is the reference for
+ * benchmarks; add optimized variants here to check them against the bit
+ * model and to compare their speed.
+ */
+typedef int blit_fn (struct bitmap *o, size_t x, size_t y,
+		     const struct bitmap *tile);
+
+struct variant {
+	const char *name;
+	blit_fn *blit;
+};
+
+static const struct variant variant[] = {
+	{ "bytes",	bitmap_blit },
+	{ NULL }
+};
+
+static uint64_t seed = 1;
+static struct bitmap_pool pool;
+
+static unsigned rnd (unsigned n)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return n == 0 ? 0 : seed % n;
+}
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Bit model: one byte per bit for both planes, trivially correct
+ */
+struct model {
+	size_t width, height;
+	unsigned char *bits, *mask;
+};
+
+static void model_init (struct model *o)
+{
+	o->width  = 0;
+	o->height = 0;
+	o->bits   = NULL;
+	o->mask   = NULL;
+}
+
+static void model_fini (struct model *o)
+{
+	free (o->bits);
+	free (o->mask);
+}
+
+static void model_resize (struct model *o, size_t x, size_t y)
+{
+	size_t width  = x < o->width  ? o->width  : x + 1;
+	size_t height = y < o->height ? o->height : y + 1;
+	unsigned char *bits, *mask;
+	size_t j;
+
+	if (width == o->width && height == o->height)
+		return;
+
+	if ((bits = calloc (width * height, 1)) == NULL ||
+	    (mask = calloc (width * height, 1)) == NULL)
+		err (1, "cannot resize bit model");
+
+	for (j = 0; j < o->height; ++j) {
+		memcpy (bits + j * width, o->bits + j * o->width, o->width);
+		memcpy (mask + j * width, o->mask + j * o->width, o->width);
+	}
+
+	model_fini (o);
+
+	o->width  = width;
+	o->height = height;
+	o->bits   = bits;
+	o->mask   = mask;
+}
+
+static void model_add (struct model *o, size_t x, size_t y, int value)
+{
+	model_resize (o, x, y);
+
+	o->bits[y * o->width + x] = value;
+	o->mask[y * o->width + x] = 1;
+}
+
+static void model_sub (struct model *o, size_t x, size_t y)
+{
+	if (x < o->width && y < o->height)
+		o->mask[y * o->width + x] = 0;
+}
+
+static void model_blit (struct model *o, size_t x, size_t y,
+			const struct model *tile)
+{
+	size_t i, j, s, d;
+
+	if (tile->width == 0 || tile->height == 0)
+		return;
+
+	model_resize (o, x + tile->width - 1, y + tile->height - 1);
+
+	for (j = 0; j < tile->height; ++j)
+		for (i = 0; i < tile->width; ++i) {
+			s = j * tile->width + i;
+			d = (y + j) * o->width + x + i;
+
+			if (tile->mask[s]) {
+				o->bits[d] = tile->bits[s];
+				o->mask[d] = 1;
+			}
+		}
+}
+
+static int plane_equal (const struct bitmap *o, const unsigned char *plane,
+			const unsigned char *ref)
+{
+	size_t i, j, k;
+	unsigned char byte;
+
+	for (j = 0; j < o->height; ++j)
+		for (i = 0; i < o->pitch; ++i) {
+			byte = 0;
+
+			for (k = 0; k < 8 && i * 8 + k < o->width; ++k)
+				byte |= ref[j * o->width + i * 8 + k] << k;
+
+			if (plane[j * o->pitch + i] != byte)
+				return 0;
+		}
+
+	return 1;
+}
+
+static int equal (const struct bitmap *o, const struct model *m)
+{
+	return	o->width == m->width && o->height == m->height &&
+		o->pitch == (m->width + 7) / 8 &&
+		plane_equal (o, o->bits, m->bits) &&
+		plane_equal (o, o->mask, m->mask);
+}
+
+/*
+ * Random tile made of chip bits, thus it goes through bitmap_add_bits
+ */
+static unsigned *make_bits (size_t width, size_t height, size_t count)
+{
+	unsigned *bits;
+	size_t i;
+
+	if ((bits = malloc ((count + 1) * sizeof (bits[0]))) == NULL)
+		err (1, "cannot allocate tile bits");
+
+	bits[0] = chip_bit_make (width - 1, height - 1, rnd (2)) |
+		  (count > 0 ? 0x8000 : 0);
+
+	for (i = 1; i <= count; ++i)
+		bits[i] = chip_bit_make (rnd (width), rnd (height), rnd (2)) |
+			  (i < count ? 0x8000 : 0);
+
+	return bits;
+}
+
+static void make_tile (struct bitmap *tile, struct model *m, size_t width,
+		       size_t height)
+{
+	unsigned *bits = make_bits (width, height, rnd (width * height / 2));
+	size_t i;
+
+	bitmap_clear (tile);
+
+	if (!bitmap_add_bits (tile, bits))
+		err (1, "cannot add bits to tile");
+
+	for (i = 0; ; ++i) {
+		model_add (m, chip_bit_x (bits[i]), chip_bit_y (bits[i]),
+			   chip_bit_value (bits[i]));
+
+		if (chip_bit_last (bits[i]))
+			break;
+	}
+
+	free (bits);
+}
+
+/*
+ * Run random operations against every variant and the bit model, and
+ * check both planes after every step
+ */
+static int fuzz (size_t rounds)
+{
+	const size_t steps = 32;
+	size_t shifts[8] = {0};
+	struct bitmap *image, *tile, *copy;
+	struct model ref, tref;
+	const struct variant *v;
+	size_t r, s, x, y;
+	int op, value;
+
+	if ((tile = bitmap_alloc ()) == NULL)
+		err (1, "cannot allocate tile");
+
+	for (v = variant; v->name != NULL; ++v)
+		for (r = 0; r < rounds; ++r) {
+			if ((image = bitmap_alloc ()) == NULL)
+				err (1, "cannot allocate image");
+
+			model_init (&ref);
+
+			for (s = 0; s < steps; ++s) {
+				x = rnd (200);
+				y = rnd (200);
+
+				switch (op = rnd (5)) {
+				case 0:
+					value = rnd (2);
+
+					if (!bitmap_add (image, x, y, value))
+						err (1, "cannot add bit");
+
+					model_add (&ref, x, y, value);
+					break;
+				case 1:
+					bitmap_sub (image, x, y);
+					model_sub (&ref, x, y);
+					break;
+				case 2:
+					if (!bitmap_resize (image, x, y))
+						err (1, "cannot resize");
+
+					model_resize (&ref, x, y);
+					break;
+				default:
+					x = (x & ~7) | (r * steps + s) % 8;
+					model_init (&tref);
+					make_tile (tile, &tref, 1 + rnd (127),
+						   1 + rnd (127));
+
+					if (!v->blit (image, x, y, tile))
+						err (1, "cannot blit");
+
+					model_blit (&ref, x, y, &tref);
+					model_fini (&tref);
+					++shifts[x & 7];
+				}
+
+				if (!equal (image, &ref)) {
+					warnx ("%s: round %zu, step %zu, op %d "
+					       "at %zu, %zu: planes differ",
+					       v->name, r, s, op, x, y);
+					return 0;
+				}
+
+				if ((copy = bitmap_pool_clone (&pool, image)) == NULL)
+					err (1, "cannot clone image");
+
+				if (!equal (copy, &ref)) {
+					warnx ("%s: round %zu, step %zu: pooled "
+					       "copy differs", v->name, r, s);
+					return 0;
+				}
+
+				bitmap_pool_put (&pool, copy);
+			}
+
+			model_fini (&ref);
+			bitmap_free (image);
+		}
+
+	printf ("fuzz: %zu rounds of %zu steps passed, blits by shift:",
+		rounds, steps);
+
+	for (s = 0; s < 8; ++s)
+		printf (" %zu", shifts[s]);
+
+	printf ("\n");
+	bitmap_free (tile);
+	bitmap_pool_fini (&pool);
+	return 1;
+}
+
+static void report (const char *name, const char *variant, int shift,
+		    double time, size_t bits, size_t bytes)
+{
+	printf ("%-10s %-8s", name, variant);
+
+	if (shift < 0)
+		printf ("        ");
+	else
+		printf (" shift %d", shift);
+
+	printf (" %10.3f ns/bit %10.3f GB/s\n", time * 1e9 / bits,
+		bytes / time / 1e9);
+}
+
+static void bench_blit (const struct variant *v, size_t count)
+{
+	const size_t width = 94, height = 48, side = 32;
+	struct bitmap *image, *tile;
+	struct model m;
+	size_t i, bits, bytes;
+	double start;
+	int shift;
+
+	if ((image = bitmap_alloc ()) == NULL ||
+	    (tile  = bitmap_alloc ()) == NULL)
+		err (1, "cannot allocate bitmaps");
+
+	model_init (&m);
+	make_tile (tile, &m, width, height);
+	model_fini (&m);
+
+	if (!bitmap_resize (image, side * width + 7, side * height))
+		err (1, "cannot resize image");
+
+	bits  = count * tile->width * tile->height;
+	bytes = count * tile->pitch * tile->height * 2;
+
+	for (shift = 0; shift < 8; ++shift) {
+		start = now ();
+
+		for (i = 0; i < count; ++i)
+			v->blit (image, (i % side) * width + shift,
+				 (i / side % side) * height, tile);
+
+		report ("blit", v->name, shift, now () - start, bits, bytes);
+	}
+
+	bitmap_free (tile);
+	bitmap_free (image);
+}
+
+static void bench_bits (size_t count)
+{
+	const size_t width = 94, height = 48;
+	struct bitmap *o;
+	unsigned *bits;
+	size_t i, j;
+	double start, time;
+
+	if ((o = bitmap_alloc ()) == NULL)
+		err (1, "cannot allocate bitmap");
+
+	bits = make_bits (width, height, 255);
+
+	for (time = 0, i = 0; i < count; ++i) {
+		bitmap_clear (o);
+		start = now ();
+
+		if (!bitmap_add_bits (o, bits))
+			err (1, "cannot add bits");
+
+		time += now () - start;
+	}
+
+	report ("add-bits", "", -1, time, count * 256, count * 256 / 8);
+
+	start = now ();
+
+	for (i = 0; i < count; ++i)
+		for (j = 0; j < 256; ++j)
+			bitmap_add (o, j % width, j % height, j & 1);
+
+	report ("add", "", -1, now () - start, count * 256, count * 256 / 8);
+
+	start = now ();
+
+	for (i = 0; i < count; ++i)
+		for (j = 0; j < 256; ++j)
+			bitmap_sub (o, j % width, j % height);
+
+	report ("sub", "", -1, now () - start, count * 256, count * 256 / 8);
+
+	free (bits);
+	bitmap_free (o);
+}
+
+/*
+ * Grow image tile by tile in raster order as chip assembly does
+ */
+static void bench_resize (size_t count)
+{
+	const size_t width = 94, height = 48, side = 16;
+	struct bitmap *o;
+	size_t i, j;
+	double start, time = 0;
+
+	if ((o = bitmap_alloc ()) == NULL)
+		err (1, "cannot allocate bitmap");
+
+	for (i = 0; i < count; ++i) {
+		bitmap_clear (o);
+		start = now ();
+
+		for (j = 0; j < side * side; ++j)
+			if (!bitmap_resize (o, (j % side + 1) * width - 1,
+					       (j / side + 1) * height - 1))
+				err (1, "cannot resize");
+
+		time += now () - start;
+	}
+
+	report ("resize", "", -1, time, count * o->width * o->height,
+		count * o->pitch * o->height * 2);
+
+	bitmap_free (o);
+}
+
+static void usage (void)
+{
+	errx (0, "\n\tbitmap-bench [-s <seed>] [-n <count>] fuzz|bench");
+}
+
+int main (int argc, char *argv[])
+{
+	const struct variant *v;
+	size_t count = 0;
+	int c;
+
+	while ((c = getopt (argc, argv, "s:n:")) != -1)
+		switch (c) {
+		case 's':
+			if ((seed = strtoull (optarg, NULL, 0)) == 0)
+				usage ();
+			break;
+		case 'n':
+			count = atol (optarg);
+			break;
+		default:
+			usage ();
+		}
+
+	if (argc - optind != 1)
+		usage ();
+
+	if (strcmp (argv[optind], "fuzz") == 0)
+		return fuzz (count > 0 ? count : 1000) ? 0 : 1;
+
+	if (strcmp (argv[optind], "bench") != 0)
+		usage ();
+
+	if (count == 0)
+		count = 100000;
+
+	for (v = variant; v->name != NULL; ++v)
+		bench_blit (v, count);
+
+	bench_bits (count / 10);
+	bench_resize (count / 1000 + 1);
+	return 0;
+}
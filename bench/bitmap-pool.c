@@ -0,0 +1,170 @@
+/*
+ * Dakota Bitmap Pool
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/bitmap.h>
+
+#include "bitmap-pool.h"
+
+#define GET_PITCH(x)	(((x) + 7) >> 3)
+
+struct bitmap_class {
+	size_t pitch, height;
+	size_t count, size;	/* released and allocated slots */
+	struct bitmap **item;
+};
+
+void bitmap_pool_fini (struct bitmap_pool *o)
+{
+	struct bitmap_class *c;
+	size_t i, j;
+
+	for (i = 0, c = o->class; i < o->count; ++i, ++c) {
+		for (j = 0; j < c->count; ++j)
+			bitmap_free (c->item[j]);
+
+		dakota_free (c->item);
+	}
+
+	dakota_free (o->class);
+
+	o->count = o->size = 0;
+	o->class = NULL;
+}
+
+/*
+ * There are few tile shapes in a family, thus linear search is enough
+ */
+static struct bitmap_class *
+bitmap_pool_find (struct bitmap_pool *o, size_t pitch, size_t height)
+{
+	struct bitmap_class *c;
+	size_t i;
+
+	for (i = 0, c = o->class; i < o->count; ++i, ++c)
+		if (c->pitch == pitch && c->height == height)
+			return c;
+
+	return NULL;
+}
+
+static struct bitmap_class *
+bitmap_pool_add (struct bitmap_pool *o, size_t pitch, size_t height)
+{
+	size_t size = o->size == 0 ? 4 : o->size * 2;
+	struct bitmap_class *c;
+
+	if (o->count == o->size) {
+		c = dakota_realloc (ALLOC_BITMAP, o->class, sizeof (*c) * size);
+		if (c == NULL)
+			return NULL;
+
+		o->class = c;
+		o->size  = size;
+	}
+
+	c = o->class + o->count++;
+
+	c->pitch  = pitch;
+	c->height = height;
+	c->count  = 0;
+	c->size   = 0;
+	c->item   = NULL;
+	return c;
+}
+
+static struct bitmap *take (struct bitmap_pool *o, size_t width, size_t height)
+{
+	const size_t pitch = GET_PITCH (width);
+	struct bitmap_class *c = bitmap_pool_find (o, pitch, height);
+	struct bitmap *b;
+
+	if (c == NULL || c->count == 0) {
+		if ((b = bitmap_alloc ()) != NULL &&
+		    !bitmap_resize (b, width - 1, height - 1)) {
+			bitmap_free (b);
+			return NULL;
+		}
+
+		return b;
+	}
+
+	b = c->item[--c->count];
+	b->width = width;
+	return b;
+}
+
+struct bitmap *
+bitmap_pool_get (struct bitmap_pool *o, size_t width, size_t height)
+{
+	struct bitmap *b;
+
+	if (width == 0 || height == 0)
+		return bitmap_alloc ();
+
+	if ((b = take (o, width, height)) == NULL)
+		return NULL;
+
+	memset (b->bits, 0, b->pitch * b->height);
+	memset (b->mask, 0, b->pitch * b->height);
+	return b;
+}
+
+struct bitmap *
+bitmap_pool_clone (struct bitmap_pool *o, const struct bitmap *from)
+{
+	struct bitmap *b;
+
+	if (from->width == 0 || from->height == 0)
+		return bitmap_alloc ();
+
+	if ((b = take (o, from->width, from->height)) == NULL)
+		return NULL;
+
+	memcpy (b->bits, from->bits, b->pitch * b->height);
+	memcpy (b->mask, from->mask, b->pitch * b->height);
+	return b;
+}
+
+/*
+ * Keep planes of heap bitmap for reuse, arena bitmaps are not pooled
+ */
+void bitmap_pool_put (struct bitmap_pool *o, struct bitmap *b)
+{
+	struct bitmap_class *c;
+	struct bitmap **item;
+	size_t size;
+
+	if (b == NULL || b->arena != NULL || b->pitch * b->height == 0)
+		goto drop;
+
+	if ((c = bitmap_pool_find (o, b->pitch, b->height)) == NULL &&
+	    (c = bitmap_pool_add  (o, b->pitch, b->height)) == NULL)
+		goto drop;
+
+	if (c->count == BITMAP_POOL_MAX)
+		goto drop;
+
+	if (c->count == c->size) {
+		size = c->size == 0 ? 16 : c->size * 2;
+		item = dakota_realloc (ALLOC_BITMAP, c->item,
+				       sizeof (item[0]) * size);
+		if (item == NULL)
+			goto drop;
+
+		c->item = item;
+		c->size = size;
+	}
+
+	c->item[c->count++] = b;
+	return;
+drop:
+	bitmap_free (b);
+}
@@ -0,0 +1,38 @@
+/*
+ * Dakota Bitmap Pool
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_BITMAP_POOL_H
+#define DAKOTA_BITMAP_POOL_H  1
+
+#include <stddef.h>
+
+#include <dakota/bitmap.h>
+
+/*
+ * Pool of released heap bitmaps keyed by shape (pitch, height): get returns
+ * cleared bitmap of given size and clone returns copy, both reuse released
+ * planes of the same shape if any. Pool keeps at most BITMAP_POOL_MAX
+ * released bitmaps of every shape, others are freed. Pool is owned by
+ * caller and is not locked. Differential test checks copies from pool.
+ */
+#define BITMAP_POOL_MAX  256
+
+struct bitmap_pool {
+	size_t count, size;	/* used and allocated classes */
+	struct bitmap_class *class;
+};
+
+void bitmap_pool_fini (struct bitmap_pool *o);
+
+struct bitmap *
+bitmap_pool_get (struct bitmap_pool *o, size_t width, size_t height);
+struct bitmap *
+bitmap_pool_clone (struct bitmap_pool *o, const struct bitmap *from);
+void bitmap_pool_put (struct bitmap_pool *o, struct bitmap *b);
+
+#endif  /* DAKOTA_BITMAP_POOL_H */
@@ -0,0 +1,709 @@
+/*
+ * Dakota Benchmarks
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <errno.h>
+#include <getopt.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#include <dakota/bitmap.h>
+#include <dakota/cache.h>
+#include <dakota/data/array.h>
+#include <dakota/model.h>
+#include <dakota/model/netlist.h>
+#include <dakota/model/reader.h>
+#include <dakota/string.h>
+#include <dakota/symbol.h>
+#include <dakota/tile.h>
+
+#include "trellis-conf.h"
+#include "trellis-map.h"
+
+enum op_type {
+	OP_TILE		= 0,
+	OP_ARROW	= 1,
+	OP_WORD		= 2,
+	OP_ENUM		= 3,
+};
+
+struct op {
+	int type;
+	char *a, *b;
+};
+
+struct placed {
+	struct tile *tile;
+	size_t x, y;
+};
+
+struct bench {
+	struct chip_conf conf;
+	const char *family;
+	char *design, *model, *image, *copy, *binary, *symbols;
+	struct cmdb *tiles, *grid;
+
+	size_t nops, maxops;
+	struct op *op;
+
+	size_t ntiles;
+	struct placed *tile;
+
+	struct bitmap *bits;
+	struct model *m;
+	size_t model_lines, copy_lines;
+	struct netlist *nl;
+
+	struct symbol *sym;
+	size_t symbol_lines;
+};
+
+static int add_op (struct bench *o, int type, const char *a, const char *b)
+{
+	size_t next = o->maxops == 0 ? 1024 : o->maxops * 2;
+	struct op *p;
+
+	if (o->nops == o->maxops) {
+		if ((p = array_resize (o->op, next)) == NULL)
+			return chip_error (&o->conf, NULL);
+
+		o->op     = p;
+		o->maxops = next;
+	}
+
+	p = o->op + o->nops;
+
+	p->type = type;
+	p->a    = strdup (a);
+	p->b    = b == NULL ? NULL : strdup (b);
+
+	if (p->a == NULL || (b != NULL && p->b == NULL)) {
+		free (p->a);
+		return chip_error (&o->conf, NULL);
+	}
+
+	++o->nops;
+	return 1;
+}
+
+static void free_ops (struct bench *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->nops; ++i) {
+		free (o->op[i].a);
+		free (o->op[i].b);
+	}
+
+	o->nops = 0;
+}
+
+static int on_device (void *cookie, const char *name)
+{
+	struct bench *o = cookie;
+
+	if (o->grid != NULL)
+		return 1;
+
+	if ((o->grid = dakota_open_grid (o->family, name, "r")) == NULL)
+		return chip_error (&o->conf, "cannot open device %s", name);
+
+	return 1;
+}
+
+static int on_comment (void *cookie, const char *value)
+{
+	return 1;
+}
+
+static int on_sysconfig (void *cookie, const char *name, const char *value)
+{
+	return 1;
+}
+
+static int on_tile (void *cookie, const char *name)
+{
+	return add_op (cookie, OP_TILE, name, NULL);
+}
+
+static int on_raw (void *cookie, unsigned bit)
+{
+	return 1;
+}
+
+static int on_arrow (void *cookie, const char *sink, const char *source)
+{
+	return add_op (cookie, OP_ARROW, sink, source);
+}
+
+static int on_word (void *cookie, const char *name, const char *value)
+{
+	return add_op (cookie, OP_WORD, name, value);
+}
+
+static int on_enum (void *cookie, const char *name, const char *value)
+{
+	return add_op (cookie, OP_ENUM, name, value);
+}
+
+static int on_bram (void *cookie, const char *name)
+{
+	return 1;
+}
+
+static int on_bram_data (void *cookie, unsigned value)
+{
+	return 1;
+}
+
+static int on_commit (void *cookie)
+{
+	return 1;
+}
+
+static const struct chip_action action = {
+	.on_device	= on_device,
+	.on_comment	= on_comment,
+	.on_sysconfig	= on_sysconfig,
+	.on_tile	= on_tile,
+	.on_raw		= on_raw,
+	.on_arrow	= on_arrow,
+	.on_word	= on_word,
+	.on_enum	= on_enum,
+	.on_bram	= on_bram,
+	.on_bram_data	= on_bram_data,
+	.on_commit	= on_commit,
+};
+
+static size_t file_size (const char *path)
+{
+	struct stat st;
+
+	return stat (path, &st) == 0 ? st.st_size : 0;
+}
+
+static size_t file_lines (const char *path)
+{
+	FILE *f;
+	size_t count = 0;
+	int c;
+
+	if ((f = fopen (path, "r")) == NULL)
+		return 0;
+
+	while ((c = getc (f)) != EOF)
+		count += (c == '\n');
+
+	fclose (f);
+	return count;
+}
+
+/*
+ * Benchmarks: every one returns number of processed items and bytes
+ */
+static int bench_parse (struct bench *o, size_t *items, size_t *bytes)
+{
+	FILE *in;
+	int ok;
+
+	free_ops (o);
+
+	if ((in = fopen (o->design, "r")) == NULL)
+		return 0;
+
+	ok = trellis_read_conf (&o->conf, in);
+	fclose (in);
+
+	if (!ok)
+		warnx ("%s: %s", o->design, o->conf.error);
+
+	*items = o->nops;
+	*bytes = file_size (o->design);
+	return ok;
+}
+
+static void free_tiles (struct bench *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->ntiles; ++i)
+		tile_free (o->tile[i].tile);
+
+	o->ntiles = 0;
+}
+
+static int place_tile (struct bench *o, const char *name, struct placed *p)
+{
+	const char *type, *x, *y;
+
+	if ((type = strchr (name, ':')) == NULL) {
+		errno = EINVAL;
+		return 0;
+	}
+
+	if (!cmdb_level (o->grid, "tile :", name, NULL) ||
+	    (x = cmdb_first (o->grid, "x")) == NULL ||
+	    (y = cmdb_first (o->grid, "y")) == NULL)
+		return 0;
+
+	p->x = atol (x);
+	p->y = atol (y);
+
+	return (p->tile = tile_alloc (o->tiles, type + 1)) != NULL;
+}
+
+static int bench_resolve (struct bench *o, size_t *items, size_t *bytes)
+{
+	struct placed *p = NULL;
+	struct op *op;
+	size_t i;
+	int ok = 1;
+
+	free_tiles (o);
+
+	if (o->tile == NULL &&
+	    (o->tile = array_alloc (o->tile, o->nops)) == NULL)
+		return 0;
+
+	for (i = 0, op = o->op; ok && i < o->nops; ++i, ++op)
+		switch (op->type) {
+		case OP_TILE:
+			p = o->tile + o->ntiles;
+			ok = place_tile (o, op->a, p);
+			o->ntiles += ok;
+			break;
+		case OP_ARROW:
+			ok = p != NULL && tile_set_mux  (p->tile, op->a, op->b);
+			break;
+		case OP_WORD:
+			ok = p != NULL && tile_set_word (p->tile, op->a, op->b);
+			break;
+		case OP_ENUM:
+			ok = p != NULL && tile_set_enum (p->tile, op->a, op->b);
+			break;
+		}
+
+	*items = o->nops;
+	*bytes = 0;
+	return ok;
+}
+
+static int bench_blit (struct bench *o, size_t *items, size_t *bytes)
+{
+	const struct bitmap *b;
+	size_t i;
+
+	bitmap_clear (o->bits);
+	*bytes = 0;
+
+	for (i = 0; i < o->ntiles; ++i) {
+		b = tile_get_bits (o->tile[i].tile);
+
+		if (!bitmap_blit (o->bits, o->tile[i].x, o->tile[i].y, b))
+			return 0;
+
+		*bytes += 2 * b->pitch * b->height;
+	}
+
+	*items = o->ntiles;
+	return 1;
+}
+
+static int bench_export (struct bench *o, size_t *items, size_t *bytes)
+{
+	if (!bitmap_export (o->bits, o->image))
+		return 0;
+
+	*items = 1;
+	*bytes = file_size (o->image);
+	return 1;
+}
+
+static int bench_map (struct bench *o, size_t *items, size_t *bytes)
+{
+	struct trellis_map *m;
+	int ok;
+
+	if ((m = trellis_map_alloc (o->family)) == NULL)
+		return 0;
+
+	if (!(ok = trellis_map (m, o->design, o->image)))
+		warnx ("%s: %s", o->design, trellis_map_error (m));
+
+	trellis_map_free (m);
+
+	*items = o->nops;
+	*bytes = file_size (o->design);
+	return ok;
+}
+
+static int bench_model_read (struct bench *o, size_t *items, size_t *bytes)
+{
+	model_free (o->m);
+
+	if ((o->m = model_read (o->model)) == NULL)
+		return 0;
+
+	if (model_status (o->m) != NULL) {
+		warnx ("%s: %s", o->model, model_status (o->m));
+		return 0;
+	}
+
+	if (o->model_lines == 0)
+		o->model_lines = file_lines (o->model);
+
+	*items = o->model_lines;
+	*bytes = file_size (o->model);
+	return 1;
+}
+
+static int on_scan_cell (void *cookie, const char *kind, const char *type)
+{
+	size_t *count = cookie;
+
+	++*count;
+	return 1;
+}
+
+static const struct model_action scan_action = {
+	.on_cell	= on_scan_cell,
+};
+
+/*
+ * Stream model through reader callbacks without building it
+ */
+static int bench_model_scan (struct bench *o, size_t *items, size_t *bytes)
+{
+	size_t count = 0;
+	struct model_reader r = { &scan_action, &count };
+
+	if (!model_parse (&r, o->model)) {
+		warnx ("%s: %zu: %s", o->model, r.lineno, r.error);
+		return 0;
+	}
+
+	*items = o->model_lines;
+	*bytes = file_size (o->model);
+	return count > 0;
+}
+
+static int bench_model_write (struct bench *o, size_t *items, size_t *bytes)
+{
+	if (!model_write (o->m, o->copy))
+		return 0;
+
+	if (o->copy_lines == 0)
+		o->copy_lines = file_lines (o->copy);
+
+	*items = o->copy_lines;
+	*bytes = file_size (o->copy);
+	return 1;
+}
+
+/*
+ * Binary model is measured in lines of text model to compare with read
+ */
+static int bench_model_save (struct bench *o, size_t *items, size_t *bytes)
+{
+	if (!model_write_binary (o->m, o->binary)) {
+		warnx ("%s: %s", o->binary, model_status (o->m));
+		return 0;
+	}
+
+	*items = o->model_lines;
+	*bytes = file_size (o->binary);
+	return 1;
+}
+
+static int bench_model_load (struct bench *o, size_t *items, size_t *bytes)
+{
+	model_free (o->m);
+
+	if ((o->m = model_load_binary (o->binary)) == NULL) {
+		warn ("%s", o->binary);
+		return 0;
+	}
+
+	*items = o->model_lines;
+	*bytes = file_size (o->binary);
+	return 1;
+}
+
+static int bench_netlist (struct bench *o, size_t *items, size_t *bytes)
+{
+	netlist_free (o->nl);
+
+	if ((o->nl = netlist_alloc (o->m)) == NULL) {
+		warnx ("%s: %s", o->model, model_status (o->m));
+		return 0;
+	}
+
+	*items = o->nl->npins;
+	*bytes = o->nl->npins * (sizeof (size_t) * 3 + 1);
+	return 1;
+}
+
+/*
+ * Follow every driver pin to loads of its net, as levelization and
+ * simulation passes do
+ */
+static int bench_fanout (struct bench *o, size_t *items, size_t *bytes)
+{
+	const struct netlist *nl = o->nl;
+	size_t c, i, j, net, edges = 0;
+
+	for (c = 0; c < nl->ncells; ++c)
+		for (i = nl->cell_pin[c]; i < nl->cell_pin[c + 1]; ++i) {
+			if (nl->pin_dir[i] != NL_OUT)
+				continue;
+
+			net = nl->pin_net[i];
+
+			for (j = nl->net_load[net]; j < nl->net_load[net + 1]; ++j)
+				edges += nl->pin_cell[nl->load[j]] != c;
+		}
+
+	*items = nl->npins;
+	*bytes = edges * sizeof (size_t);
+	return edges > 0;
+}
+
+static int bench_symbol_read (struct bench *o, size_t *items, size_t *bytes)
+{
+	symbol_free (o->sym);
+
+	if ((o->sym = symbol_read ("bench", o->symbols)) == NULL)
+		return 0;
+
+	if (o->symbol_lines == 0)
+		o->symbol_lines = file_lines (o->symbols);
+
+	*items = o->symbol_lines;
+	*bytes = file_size (o->symbols);
+	return 1;
+}
+
+/*
+ * Resolve every blit from the tile it is placed in, as renderer does
+ */
+struct sheet {
+	struct symbol *scope[16];
+	size_t depth, blits, missed;
+};
+
+static int on_symbol (void *cookie, int type, int x, int y, ...)
+{
+	struct sheet *o = cookie;
+	struct symbol *s;
+	const char *name;
+	va_list ap;
+
+	va_start (ap, y);
+
+	switch (type) {
+	case SYMBOL_TILE:
+		name = va_arg (ap, const char *);
+		s = symbol_get_tile (o->scope[o->depth], name);
+
+		if (s == NULL || ++o->depth >= 16)
+			goto error;
+
+		o->scope[o->depth] = s;
+		break;
+	case SYMBOL_END:
+		--o->depth;
+		break;
+	case SYMBOL_BLIT:
+		(void) va_arg (ap, int);
+		name = va_arg (ap, const char *);
+
+		++o->blits;
+		o->missed += symbol_get_tile (o->scope[o->depth], name) == NULL;
+		break;
+	}
+
+	va_end (ap);
+	return 1;
+error:
+	va_end (ap);
+	return 0;
+}
+
+static int bench_symbol_blit (struct bench *o, size_t *items, size_t *bytes)
+{
+	struct sheet s = { { o->sym } };
+
+	if (!symbol_walk (o->sym, on_symbol, &s))
+		return 0;
+
+	if (s.missed > 0) {
+		warnx ("%zu of %zu blits are not resolved", s.missed, s.blits);
+		return 0;
+	}
+
+	*items = s.blits;
+	*bytes = 0;
+	return 1;
+}
+
+struct bench_entry {
+	const char *name, *unit;
+	int (*run) (struct bench *o, size_t *items, size_t *bytes);
+};
+
+/*
+ * Benchmarks run in order, every one uses results of previous ones
+ */
+static const struct bench_entry table[] = {
+	{ "parse",	 "records",	bench_parse	  },
+	{ "resolve",	 "records",	bench_resolve	  },
+	{ "blit",	 "tiles",	bench_blit	  },
+	{ "export",	 "images",	bench_export	  },
+	{ "map",	 "records",	bench_map	  },
+	{ "model-read",	 "lines",	bench_model_read  },
+	{ "model-scan",	 "lines",	bench_model_scan  },
+	{ "model-write", "lines",	bench_model_write },
+	{ "model-save",	 "lines",	bench_model_save  },
+	{ "model-load",	 "lines",	bench_model_load  },
+	{ "netlist",	 "pins",	bench_netlist	  },
+	{ "fanout",	 "pins",	bench_fanout	  },
+	{ "symbol-read", "lines",	bench_symbol_read },
+	{ "symbol-blit", "blits",	bench_symbol_blit },
+	{ NULL }
+};
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Run benchmark several times and report the best time
+ */
+static int run (struct bench *o, const struct bench_entry *e, int reps)
+{
+	size_t items = 0, bytes = 0;
+	double best = 0, start, time;
+	int i;
+
+	for (i = 0; i < reps; ++i) {
+		start = now ();
+
+		if (!e->run (o, &items, &bytes))
+			return 0;
+
+		time = now () - start;
+
+		if (i == 0 || time < best)
+			best = time;
+	}
+
+	if (best <= 0)
+		best = 1e-9;
+
+	printf ("%-12s %12zu %-8s %12.3f %14.0f %10.2f\n", e->name, items,
+		e->unit, best * 1e3, items / best, bytes / best / 1e6);
+	return 1;
+}
+
+static int bench_init (struct bench *o, const char *family, const char *prefix)
+{
+	memset (o, 0, sizeof (*o));
+
+	o->conf.action = &action;
+	o->conf.cookie = o;
+	o->family      = family;
+
+	o->design  = make_string ("%s.trellis",   prefix);
+	o->model   = make_string ("%s.blif",      prefix);
+	o->image   = make_string ("%s.pnm",       prefix);
+	o->copy    = make_string ("%s-copy.blif", prefix);
+	o->binary  = make_string ("%s.dkm",       prefix);
+	o->symbols = make_string ("%s.symbols",   prefix);
+
+	if (o->design == NULL || o->model == NULL || o->image == NULL ||
+	    o->copy == NULL || o->binary == NULL || o->symbols == NULL)
+		return 0;
+
+	if ((o->bits = bitmap_alloc ()) == NULL)
+		return 0;
+
+	return (o->tiles = dakota_open_tiles (family, "r")) != NULL;
+}
+
+static void bench_fini (struct bench *o)
+{
+	free_ops (o);
+	array_free (o->op, o->nops, NULL);
+	free_tiles (o);
+	array_free (o->tile, o->ntiles, NULL);
+	netlist_free (o->nl);
+	model_free (o->m);
+	symbol_free (o->sym);
+	bitmap_free (o->bits);
+
+	if (o->grid != NULL)
+		dakota_close (o->grid);
+
+	if (o->tiles != NULL)
+		dakota_close (o->tiles);
+
+	free (o->design);
+	free (o->model);
+	free (o->image);
+	free (o->copy);
+	free (o->binary);
+	free (o->symbols);
+}
+
+static void usage (void)
+{
+	errx (0, "\n\tdakota-bench [-r <repeats>] <family> <prefix>");
+}
+
+int main (int argc, char *argv[])
+{
+	struct bench o;
+	const struct bench_entry *e;
+	int c, reps = 5, ok = 1;
+
+	while ((c = getopt (argc, argv, "r:")) != -1)
+		switch (c) {
+		case 'r':
+			if ((reps = atoi (optarg)) < 1)
+				usage ();
+			break;
+		default:
+			usage ();
+		}
+
+	if (argc - optind != 2)
+		usage ();
+
+	if (!bench_init (&o, argv[optind], argv[optind + 1]))
+		err (1, "cannot initialize benchmarks");
+
+	printf ("%-12s %12s %-8s %12s %14s %10s\n", "bench", "items", "unit",
+		"best, ms", "items/s", "MB/s");
+
+	for (e = table; ok && e->name != NULL; ++e)
+		if (!(ok = run (&o, e, reps)))
+			warn ("%s benchmark failed", e->name);
+
+	bench_fini (&o);
+	return ok ? 0 : 1;
+}
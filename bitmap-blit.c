@@ -7,15 +7,18 @@
  */
 
 #include <dakota/bitmap.h>
+#include <dakota/stats.h>
 
 int bitmap_blit (struct bitmap *o, size_t x, size_t y,
 		 const struct bitmap *tile)
 {
 	const size_t rshift = (x & 7);
 	const size_t lshift = 8 - rshift;
+	const int tail = rshift + tile->width > tile->pitch * 8;
 
 	unsigned prev_mask, prev_bits, mask, bits;
 	size_t start_src, start_dst, src, dst, i, j;
+	uint64_t span;
 
 	if (tile->width == 0 || tile->height == 0)
 		return 1;
@@ -23,6 +26,8 @@ int bitmap_blit (struct bitmap *o, size_t x, size_t y,
 	if (!bitmap_resize (o, x + tile->width - 1, y + tile->height - 1))
 		return 0;
 
+	span = stats_begin ();
+
 	for (
 		start_src = 0, start_dst = y * o->pitch + (x >> 3), j = 0;
 		j < tile->height;
@@ -45,12 +50,13 @@ int bitmap_blit (struct bitmap *o, size_t x, size_t y,
 			prev_bits = (tile->bits[src] >> lshift);
 		}
 
-		if (rshift != 0) {
+		if (tail) {  /* shifted row spans one more byte */
 			o->mask[dst] |=  prev_mask;
 			o->bits[dst] &= ~prev_mask;
 			o->bits[dst] |=  prev_bits;
 		}
 	}
 
+	stats_end (STATS_BLIT, span, tile->pitch * tile->height);
 	return 1;
 }
@@ -9,7 +9,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <dakota/alloc.h>
 #include <dakota/bitmap.h>
+#include <dakota/stats.h>
 
 #define GET_PITCH(x)	(((x) + 7) >> 3)
 
@@ -37,19 +39,25 @@ static unsigned char *pbm_import (FILE *in, size_t *w, size_t *h)
 {
 	unsigned char *data;
 	size_t count;
+	int a;
+
+	if (fscanf (in, " P4 %zu %zu", w, h) != 2)
+		return NULL;
+
+	/* exactly one white space character separates header from data */
 
-	if (fscanf (in, "P4 %zu %zu ", w, h) != 2)
+	if ((a = fgetc (in)) != ' ' && a != '\t' && a != '\n' && a != '\r')
 		return NULL;
 
 	count = GET_PITCH (*w) * *h;
 
-	if ((data = malloc (count)) == NULL)
+	if ((data = dakota_alloc (ALLOC_BITMAP, count)) == NULL)
 		return NULL;
 
 	if (pbm_import_data (in, data, count))
 		return data;
 
-	free (data);
+	dakota_free (data);
 	return 0;
 }
 
@@ -74,6 +82,17 @@ static int pbm_export (FILE *out, size_t w, size_t h, const unsigned char *data)
 	return pbm_export_data (out, data, count);
 }
 
+static int has_more (FILE *in)
+{
+	int a;
+
+	if ((a = fgetc (in)) == EOF)
+		return 0;
+
+	ungetc (a, in);
+	return 1;
+}
+
 struct bitmap *bitmap_import (const char *path)
 {
 	FILE *in;
@@ -92,10 +111,13 @@ struct bitmap *bitmap_import (const char *path)
 
 	o->width  = w;
 	o->height = h;
+	o->pitch  = GET_PITCH (w);
 	o->bits   = bits;
 
-	if (feof (in)) {
-		if ((o->mask = calloc (o->pitch * h, 1)) == NULL)
+	if (!has_more (in)) {
+		o->mask = dakota_zalloc (ALLOC_BITMAP, o->pitch * h);
+
+		if (o->mask == NULL)
 			goto no_import;
 	}
 	else {
@@ -128,6 +150,7 @@ static int is_zero (const unsigned char *data, size_t count)
 
 int bitmap_export (const struct bitmap *o, const char *path)
 {
+	const uint64_t span = stats_begin ();
 	FILE *out;
 	int ok;
 
@@ -146,6 +169,7 @@ int bitmap_export (const struct bitmap *o, const char *path)
 	if (!ok)
 		remove (path);
 
+	stats_end (STATS_EXPORT, span, o->pitch * o->height);
 	return ok;
 	return 0;
 }
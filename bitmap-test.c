@@ -25,7 +25,7 @@ int main (int argc, char *argv[])
 	if ((tile = bitmap_alloc ()) == NULL)
 		errx (1, "cannot allocate tile bitmap");
 
-	bits = chip_bits_parse (sample);
+	bits = chip_bits_parse (sample, NULL);
 
 	if (!bitmap_add_bits (tile, bits))
 		err (1, "cammot add bits to tile");
@@ -9,45 +9,82 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/alloc.h>
 #include <dakota/bitmap.h>
+#include <dakota/stats.h>
 
-struct bitmap *bitmap_alloc (void)
+static void bitmap_init (struct bitmap *o, struct arena *arena)
 {
-	struct bitmap *o;
-
-	if ((o = malloc (sizeof (*o))) == NULL)
-		return NULL;
-
 	o->width  = 0;
 	o->height = 0;
 	o->pitch  = 0;
 	o->bits   = NULL;
 	o->mask   = NULL;
+	o->arena  = arena;
+}
+
+struct bitmap *bitmap_alloc (void)
+{
+	struct bitmap *o;
+
+	if ((o = dakota_alloc (ALLOC_BITMAP, sizeof (*o))) == NULL)
+		return NULL;
+
+	bitmap_init (o, NULL);
 	return o;
 }
 
+/*
+ * Planes of arena bitmap are left in arena until reset
+ */
+static void *plane_alloc (struct bitmap *o, size_t size)
+{
+	return	o->arena == NULL ? dakota_zalloc (ALLOC_BITMAP, size) :
+				   arena_zalloc (o->arena, size);
+}
+
+static void plane_free (struct bitmap *o, void *p)
+{
+	if (o->arena == NULL)
+		dakota_free (p);
+}
+
 void bitmap_free (struct bitmap *o)
 {
-	if (o == NULL)
+	if (o == NULL || o->arena != NULL)
 		return;
 
-	free (o->bits);
-	free (o->mask);
-	free (o);
+	dakota_free (o->bits);
+	dakota_free (o->mask);
+	dakota_free (o);
+}
+
+void bitmap_clear (struct bitmap *o)
+{
+	plane_free (o, o->bits);
+	plane_free (o, o->mask);
+
+	bitmap_init (o, o->arena);
 }
 
-struct bitmap *bitmap_clone (const struct bitmap *from)
+struct bitmap *bitmap_clone (const struct bitmap *from, struct arena *arena)
 {
 	struct bitmap *o;
 	size_t size;
 
-	if ((o = bitmap_alloc ()) == NULL)
+	if (arena == NULL)
+		o = bitmap_alloc ();
+	else if ((o = arena_alloc (arena, sizeof (*o))) != NULL)
+		bitmap_init (o, arena);
+
+	if (o == NULL)
 		return NULL;
 
-	size = from->pitch * from->height;
+	if ((size = from->pitch * from->height) == 0)
+		return o;
 
-	if ((o->bits = malloc (size)) == NULL ||
-	    (o->mask = malloc (size)) == NULL)
+	if ((o->bits = plane_alloc (o, size)) == NULL ||
+	    (o->mask = plane_alloc (o, size)) == NULL)
 		goto no_mem;
 
 	memcpy (o->bits, from->bits, size);
@@ -71,18 +108,20 @@ int bitmap_resize (struct bitmap *o, size_t x, size_t y)
 	size_t pitch  = GET_PITCH (width);
 	size_t size;
 	unsigned char *bits, *mask;
+	uint64_t span;
 
 	if (pitch == o->pitch && height == o->height) {
 		o->width = width;
 		return 1;
 	}
 
+	span = stats_begin ();
 	size = pitch * height;
 
-	if ((bits = calloc (size, 1)) == NULL)
+	if ((bits = plane_alloc (o, size)) == NULL)
 		return 0;
 
-	if ((mask = calloc (size, 1)) == NULL)
+	if ((mask = plane_alloc (o, size)) == NULL)
 		goto no_mask;
 
 	for (y = 0; y < o->height; ++y) {
@@ -90,8 +129,10 @@ int bitmap_resize (struct bitmap *o, size_t x, size_t y)
 		memcpy (mask + y * pitch, o->mask + y * o->pitch, o->pitch);
 	}
 
-	free (o->bits);
-	free (o->mask);
+	stats_end (STATS_RESIZE, span, 2 * o->pitch * o->height);
+
+	plane_free (o, o->bits);
+	plane_free (o, o->mask);
 
 	o->width  = width;
 	o->height = height;
@@ -100,10 +141,37 @@ int bitmap_resize (struct bitmap *o, size_t x, size_t y)
 	o->mask   = mask;
 	return 1;
 no_mask:
-	free (bits);
+	plane_free (o, bits);
 	return 0;
 }
 
+/*
+ * Clear both bits and mask in the rectangle w x h at position x, y
+ */
+void bitmap_erase (struct bitmap *o, size_t x, size_t y, size_t w, size_t h)
+{
+	size_t end, i, j, pos;
+	unsigned char pattern;
+
+	if (x >= o->width || y >= o->height)
+		return;
+
+	end = (w < o->width  - x) ? x + w : o->width;
+	h   = (h < o->height - y) ? h     : o->height - y;
+
+	for (j = 0; j < h; ++j)
+		for (i = x; i < end; i = (i | 7) + 1) {
+			pos = (y + j) * o->pitch + (i >> 3);
+			pattern = 0xff << (i & 7);
+
+			if ((end - 1) >> 3 == i >> 3)
+				pattern &= 0xff >> (7 - ((end - 1) & 7));
+
+			o->bits[pos] &= ~pattern;
+			o->mask[pos] &= ~pattern;
+		}
+}
+
 int bitmap_add (struct bitmap *o, size_t x, size_t y, int value)
 {
 	size_t i;
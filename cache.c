@@ -7,49 +7,201 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <dakota/cache.h>
 #include <dakota/string.h>
 
+/*
+ * Opened databases are shared: each handle is kept in the registry keyed
+ * by (family, device, mode) together with reference counter, and closed
+ * when the last user releases it with dakota_close. Registry is guarded
+ * by lock, thus databases may be opened and closed from any thread.
+ */
+struct entry {
+	struct entry *next;
+	char *family, *device, *mode;
+	struct cmdb *db;
+	size_t refs;
+};
+
 static const char *home;
+static struct entry *cache;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int prefetch;
 
-struct cmdb *dakota_open_tiles (const char *family, const char *mode)
+static int match (const char *a, const char *b)
+{
+	if (a == NULL || b == NULL)
+		return a == b;
+
+	return strcmp (a, b) == 0;
+}
+
+static struct entry *
+entry_lookup (const char *family, const char *device, const char *mode)
+{
+	struct entry *e;
+
+	for (e = cache; e != NULL; e = e->next)
+		if (match (e->family, family) && match (e->device, device) &&
+		    match (e->mode, mode))
+			return e;
+
+	return NULL;
+}
+
+static void entry_free (struct entry *o)
+{
+	if (o == NULL)
+		return;
+
+	free (o->family);
+	free (o->device);
+	free (o->mode);
+	free (o);
+}
+
+static struct entry *
+entry_alloc (const char *family, const char *device, const char *mode)
 {
+	struct entry *o;
+
+	if ((o = calloc (1, sizeof (*o))) == NULL)
+		return NULL;
+
+	if ((o->family = strdup (family)) == NULL ||
+	    (device != NULL && (o->device = strdup (device)) == NULL) ||
+	    (o->mode = strdup (mode)) == NULL)
+		goto no_key;
+
+	return o;
+no_key:
+	entry_free (o);
+	return NULL;
+}
+
+/*
+ * Ask kernel to read database file in advance: we do not know how cmdb
+ * lays out its data, thus warm up the whole file in page cache.
+ */
+static void warm_up (const char *path)
+{
+	int fd;
+
+	if ((fd = open (path, O_RDONLY)) < 0)
+		return;
+
+	posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+	close (fd);
+}
+
+static struct cmdb *
+cache_open_locked (const char *family, const char *device, const char *mode)
+{
+	struct entry *e;
 	char *path;
-	struct cmdb *db;
+
+	if ((e = entry_lookup (family, device, mode)) != NULL) {
+		++e->refs;
+		return e->db;
+	}
 
 	if (home == NULL && (home = getenv ("HOME")) == NULL) {
 		errno = ENOENT;
 		return NULL;
 	}
 
-	path = make_string ("%s/.cache/dakota/db/%s.cmdb", home, family);
+	path = device == NULL ?
+	       make_string ("%s/.cache/dakota/db/%s.cmdb", home, family) :
+	       make_string ("%s/.cache/dakota/db/%s-%s.cmdb",
+			    home, family, device);
 	if (path == NULL)
 		return NULL;
 
-	db = cmdb_open (path, mode);
+	if ((e = entry_alloc (family, device, mode)) == NULL)
+		goto no_entry;
+
+	if (prefetch)
+		warm_up (path);
+
+	if ((e->db = cmdb_open (path, mode)) == NULL)
+		goto no_db;
+
+	free (path);
+
+	e->refs = 1;
+	e->next = cache;
+	cache = e;
+	return e->db;
+no_db:
+	entry_free (e);
+no_entry:
 	free (path);
+	return NULL;
+}
+
+static struct cmdb *
+cache_open (const char *family, const char *device, const char *mode)
+{
+	struct cmdb *db;
+
+	pthread_mutex_lock (&lock);
+	db = cache_open_locked (family, device, mode);
+	pthread_mutex_unlock (&lock);
 	return db;
 }
 
+struct cmdb *dakota_open_tiles (const char *family, const char *mode)
+{
+	return cache_open (family, NULL, mode);
+}
+
 struct cmdb *
 dakota_open_grid (const char *family, const char *device, const char *mode)
 {
-	char *path;
-	struct cmdb *db;
+	return cache_open (family, device, mode);
+}
 
-	if (home == NULL && (home = getenv ("HOME")) == NULL) {
-		errno = ENOENT;
-		return NULL;
+int dakota_close (struct cmdb *db)
+{
+	struct entry **p, *e;
+	int ok;
+
+	if (db == NULL)
+		return 1;
+
+	pthread_mutex_lock (&lock);
+
+	for (p = &cache; (e = *p) != NULL; p = &e->next)
+		if (e->db == db)
+			break;
+
+	if (e != NULL && --e->refs > 0) {
+		pthread_mutex_unlock (&lock);
+		return 1;
 	}
 
-	path = make_string ("%s/.cache/dakota/db/%s-%s.cmdb",
-			    home, family, device);
-	if (path == NULL)
-		return NULL;
+	if (e != NULL)
+		*p = e->next;
 
-	db = cmdb_open (path, mode);
-	free (path);
-	return db;
+	pthread_mutex_unlock (&lock);
+
+	if (e == NULL)
+		return cmdb_close (db);  /* not opened by us */
+
+	ok = cmdb_close (e->db);
+	entry_free (e);
+	return ok;
+}
+
+void dakota_cache_prefetch (int enable)
+{
+	pthread_mutex_lock (&lock);
+	prefetch = enable;
+	pthread_mutex_unlock (&lock);
 }
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/arena.h>
 #include <dakota/chip-bits.h>
 
 int chip_bit_parse (const char *s)
@@ -59,7 +60,7 @@ static size_t chip_bits_count (const char *s)
 	return count;
 }
 
-unsigned *chip_bits_parse (const char *s)
+unsigned *chip_bits_parse (const char *s, struct arena *arena)
 {
 	int bit;
 	size_t count, i;
@@ -69,8 +70,9 @@ unsigned *chip_bits_parse (const char *s)
 		return NULL;
 
 	count = chip_bits_count (s);
-
-	if ((bits = malloc (sizeof (bits[0]) * count)) == NULL)
+	bits  = arena == NULL ? malloc (sizeof (bits[0]) * count) :
+				arena_alloc (arena, sizeof (bits[0]) * count);
+	if (bits == NULL)
 		return NULL;
 
 	bits[0] = bit;
@@ -84,6 +86,20 @@ unsigned *chip_bits_parse (const char *s)
 	return bits;
 }
 
+void chip_bits_extent (const char *s, size_t *width, size_t *height)
+{
+	int bit;
+	size_t x, y;
+
+	for (; (bit = chip_bit_parse (s)) >= 0; s = next_word (s)) {
+		x = chip_bit_x (bit);
+		y = chip_bit_y (bit);
+
+		*width  = x < *width  ? *width  : x + 1;
+		*height = y < *height ? *height : y + 1;
+	}
+}
+
 void chip_bits_invert (unsigned *bits)
 {
 	if (bits == NULL)
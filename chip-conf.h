@@ -40,6 +40,7 @@ struct chip_conf {
 	const struct chip_action *action;
 	void *cookie;
 
+	size_t records;		/* records read */
 	char error[256];
 };
 
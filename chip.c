@@ -12,9 +12,15 @@
 
 #include <dakota/chip.h>
 #include <dakota/chiplet.h>
+#include <dakota/stats.h>
 
+/*
+ * All per-commit objects are allocated from arena, thus commit releases
+ * them at once
+ */
 struct chip {
 	struct cmdb *grid;
+	struct arena arena;
 	struct chiplet *chiplet;
 	struct bitmap *image;
 };
@@ -27,8 +33,9 @@ struct chip *chip_alloc (struct cmdb *tiles, struct cmdb *grid)
 		return NULL;
 
 	o->grid = grid;
+	arena_init (&o->arena);
 
-	if ((o->chiplet = chiplet_alloc (tiles)) == NULL)
+	if ((o->chiplet = chiplet_alloc (tiles, &o->arena)) == NULL)
 		goto no_chiplet;
 
 	if ((o->image = bitmap_alloc ()) == NULL)
@@ -49,9 +56,27 @@ void chip_free (struct chip *o)
 
 	bitmap_free (o->image);
 	chiplet_free (o->chiplet);
+	arena_fini (&o->arena);
 	free (o);
 }
 
+static void chip_release (struct chip *o)
+{
+	chiplet_reset (o->chiplet);
+	arena_reset (&o->arena);
+}
+
+/*
+ * Prepare chip to map next design: forget device grid and image, but keep
+ * resolved tile prototypes
+ */
+void chip_reset (struct chip *o)
+{
+	chip_release (o);
+	bitmap_clear (o->image);
+	o->grid = NULL;
+}
+
 int chip_add_grid (struct chip *o, struct cmdb *grid)
 {
 	if (o->grid != NULL) {
@@ -65,7 +90,8 @@ int chip_add_grid (struct chip *o, struct cmdb *grid)
 
 int chip_add_tile (struct chip *o, const char *name, const char *type)
 {
-	const char *v;
+	const char *v, *w;
+	uint64_t span;
 	size_t x, y;
 
 	if (o->grid == NULL) {
@@ -73,16 +99,21 @@ int chip_add_tile (struct chip *o, const char *name, const char *type)
 		return 0;
 	}
 
+	span = stats_begin ();
+
 	if (!cmdb_level (o->grid, "tile :", name, NULL) ||
 	    (v = cmdb_first (o->grid, "x")) == NULL)
-		return 0;
+		w = v = NULL;
+	else
+		w = cmdb_first (o->grid, "y");
 
-	x = atol (v);
+	stats_end (STATS_LOOKUP, span, 1);
 
-	if ((v = cmdb_first (o->grid, "y")) == NULL)
+	if (v == NULL || w == NULL)
 		return 0;
 
-	y = atol (v);
+	x = atol (v);
+	y = atol (w);
 
 	if (!chiplet_add (o->chiplet, x, y, type))
 		return 0;
@@ -114,11 +145,32 @@ int chip_commit (struct chip *o)
 {
 	int ok = chiplet_blit (o->chiplet, o->image);
 
-	chiplet_reset (o->chiplet);
+	chip_release (o);
 
 	return ok;
 }
 
+struct bitmap *chip_commit_apart (struct chip *o, size_t *x, size_t *y)
+{
+	struct bitmap *map;
+
+	if ((map = bitmap_alloc ()) == NULL)
+		goto no_map;
+
+	chiplet_origin (o->chiplet, x, y);
+
+	if (!chiplet_blit_at (o->chiplet, map, *x, *y))
+		goto no_blit;
+
+	chip_release (o);
+	return map;
+no_blit:
+	bitmap_free (map);
+no_map:
+	chip_release (o);
+	return NULL;
+}
+
 const struct bitmap *chip_get_bits (const struct chip *o)
 {
 	return o->image;
@@ -8,9 +8,36 @@
 
 #include <stdlib.h>
 
+#include <dakota/alloc.h>
 #include <dakota/chiplet.h>
+#include <dakota/data/hash.h>
+#include <dakota/data/intern.h>
 #include <dakota/tile.h>
 
+/*
+ * Tile prototype: tile of given type with initial (raw) bits resolved,
+ * new tiles of the same type are cloned from it
+ */
+
+struct proto {
+	struct proto *next;
+	struct tile *tile;
+};
+
+static void proto_free (struct proto *o)
+{
+	struct proto *next;
+
+	for (; o != NULL; o = next) {
+		next = o->next;
+		tile_free (o->tile);
+		dakota_free (o);
+	}
+}
+
+#define PROTO_ORDER  6
+#define PROTO_SIZE   (1 << PROTO_ORDER)
+
 /* chiplet unit */
 
 struct unit {
@@ -19,52 +46,66 @@ struct unit {
 	struct tile *tile;
 };
 
-static
-struct unit *unit_alloc (struct cmdb *db, size_t x, size_t y, const char *type)
+/*
+ * Units and their tiles live in the arena of chiplet owner and are
+ * released all at once by arena reset, or live in the heap and are freed
+ * by chiplet reset if there is no arena
+ */
+static struct unit *
+unit_alloc (struct arena *a, const struct tile *proto, size_t x, size_t y)
 {
 	struct unit *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	o = a == NULL ? dakota_alloc (ALLOC_CHIPLET, sizeof (*o)) :
+			arena_alloc (a, sizeof (*o));
+	if (o == NULL)
 		return NULL;
 
 	o->next = NULL;
 	o->x    = x;
 	o->y    = y;
 
-	if ((o->tile = tile_alloc (db, type)) == NULL)
+	if ((o->tile = tile_clone (proto, a)) == NULL)
 		goto no_tile;
 
 	return o;
 no_tile:
-	free (o);
+	if (a == NULL)
+		dakota_free (o);
+
 	return NULL;
 }
 
 static void unit_free (struct unit *o)
 {
-	if (o == NULL)
-		return;
-
 	tile_free (o->tile);
-	free (o);
+	dakota_free (o);
 }
 
 /* chiplet */
 
 struct chiplet {
 	struct cmdb *db;
+	struct arena *arena;
 	struct unit *set;
+	struct proto *proto[PROTO_SIZE];
 };
 
-struct chiplet *chiplet_alloc (struct cmdb *db)
+struct chiplet *chiplet_alloc (struct cmdb *db, struct arena *arena)
 {
 	struct chiplet *o;
+	size_t i;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	if ((o = dakota_alloc (ALLOC_CHIPLET, sizeof (*o))) == NULL)
 		return NULL;
 
-	o->db  = db;
-	o->set = NULL;
+	o->db    = db;
+	o->arena = arena;
+	o->set   = NULL;
+
+	for (i = 0; i < PROTO_SIZE; ++i)
+		o->proto[i] = NULL;
+
 	return o;
 }
 
@@ -72,28 +113,62 @@ void chiplet_reset (struct chiplet *o)
 {
 	struct unit *u, *next;
 
-	for (u = o->set; u != NULL; u = next) {
-		next = u->next;
-		unit_free (u);
-	}
+	if (o->arena == NULL)
+		for (u = o->set; u != NULL; u = next) {
+			next = u->next;
+			unit_free (u);
+		}
 
 	o->set = NULL;
 }
 
 void chiplet_free (struct chiplet *o)
 {
+	size_t i;
+
 	if (o == NULL)
 		return;
 
 	chiplet_reset (o);
-	free (o);
+
+	for (i = 0; i < PROTO_SIZE; ++i)
+		proto_free (o->proto[i]);
+
+	dakota_free (o);
+}
+
+static
+const struct tile *chiplet_get_proto (struct chiplet *o, const char *type)
+{
+	const size_t i = hash_string (HASH_INIT, type) & (PROTO_SIZE - 1);
+	const char *name = intern_lookup (type);  /* tile types are interned */
+	struct proto *p;
+
+	for (p = o->proto[i]; p != NULL; p = p->next)
+		if (tile_get_type (p->tile) == name)
+			return p->tile;
+
+	if ((p = dakota_alloc (ALLOC_CHIPLET, sizeof (*p))) == NULL)
+		return NULL;
+
+	if ((p->tile = tile_alloc (o->db, type)) == NULL)
+		goto no_tile;
+
+	p->next = o->proto[i];
+	o->proto[i] = p;
+	return p->tile;
+no_tile:
+	dakota_free (p);
+	return NULL;
 }
 
 int chiplet_add (struct chiplet *o, size_t x, size_t y, const char *type)
 {
+	const struct tile *proto;
 	struct unit *u;
 
-	if ((u = unit_alloc (o->db, x, y, type)) == NULL)
+	if ((proto = chiplet_get_proto (o, type)) == NULL ||
+	    (u = unit_alloc (o->arena, proto, x, y)) == NULL)
 		return 0;
 
 	u->next = o->set;
@@ -145,13 +220,37 @@ int chiplet_set_enum (struct chiplet *o, const char *name, const char *value)
 	return ok;
 }
 
-int chiplet_blit (const struct chiplet *o, struct bitmap *image)
+void chiplet_origin (const struct chiplet *o, size_t *x, size_t *y)
 {
 	struct unit *u;
+
+	if ((u = o->set) == NULL) {
+		*x = *y = 0;
+		return;
+	}
+
+	for (*x = u->x, *y = u->y; u != NULL; u = u->next) {
+		*x = u->x < *x ? u->x : *x;
+		*y = u->y < *y ? u->y : *y;
+	}
+}
+
+int chiplet_blit_at (const struct chiplet *o, struct bitmap *image,
+		     size_t x, size_t y)
+{
+	struct unit *u;
+	const struct bitmap *bits;
 	int ok = 1;
 
-	for (u = o->set; u != NULL; u = u->next)
-		ok &= bitmap_blit (image, u->x, u->y, tile_get_bits (u->tile));
+	for (u = o->set; u != NULL; u = u->next) {
+		bits = tile_get_bits (u->tile);
+		ok &= bitmap_blit (image, u->x - x, u->y - y, bits);
+	}
 
 	return ok;
 }
+
+int chiplet_blit (const struct chiplet *o, struct bitmap *image)
+{
+	return chiplet_blit_at (o, image, 0, 0);
+}
@@ -0,0 +1,230 @@
+/*
+ * Dakota Design Map Service
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <err.h>
+
+#include <dakota/cache.h>
+#include <dakota/data/array.h>
+
+#include "trellis-map.h"
+
+/*
+ * Protocol: client sends requests one per line, service answers to each
+ * request with one line, "ok" on success or "error <reason>" on failure:
+ *
+ *	map <family> <design.trellis> <out.pnm>
+ *
+ * Fields are separated by blanks, field in double quotes may contain
+ * blanks. Paths are resolved relative to the working directory of
+ * service, thus clients should pass absolute paths. Mappers (opened databases and
+ * resolved tiles) are kept for every family requested.
+ */
+
+struct service {
+	size_t nmaps;
+	struct trellis_map **map;
+};
+
+static struct trellis_map *
+service_get_map (struct service *o, const char *family)
+{
+	const size_t nmaps = o->nmaps + 1;
+	struct trellis_map **p, *m;
+	size_t i;
+
+	for (i = 0; i < o->nmaps; ++i)
+		if (strcmp (trellis_map_family (o->map[i]), family) == 0)
+			return o->map[i];
+
+	if ((p = array_resize (o->map, nmaps)) == NULL)
+		return NULL;
+
+	o->map = p;
+
+	if ((m = trellis_map_alloc (family)) == NULL)
+		return NULL;
+
+	o->map[o->nmaps] = m;
+	o->nmaps = nmaps;
+	return m;
+}
+
+static int reply (FILE *out, const char *status, const char *reason)
+{
+	if (reason == NULL)
+		fprintf (out, "%s\n", status);
+	else
+		fprintf (out, "%s %s\n", status, reason);
+
+	return fflush (out) == 0;
+}
+
+/*
+ * Cut next field of request in place, returns NULL if there are no more
+ * fields or if closing quote is missing, the line is kept intact then
+ */
+static char *next_field (char **line)
+{
+	char *p = *line + strspn (*line, " \t"), *end;
+
+	if (*p == '\0')
+		return NULL;
+
+	if (*p != '"')
+		end = p + strcspn (p, " \t");
+	else if ((end = strchr (++p, '"')) == NULL)
+		return NULL;
+
+	if (*end != '\0')
+		*end++ = '\0';
+
+	*line = end;
+	return p;
+}
+
+static int on_map (struct service *o, char *args, FILE *out)
+{
+	const char *family, *in, *out_path;
+	struct trellis_map *m;
+
+	if ((family   = next_field (&args)) == NULL ||
+	    (in       = next_field (&args)) == NULL ||
+	    (out_path = next_field (&args)) == NULL ||
+	    args[strspn (args, " \t")] != '\0')
+		return reply (out, "error", "map requires family, input and "
+				     "output");
+
+	if ((m = service_get_map (o, family)) == NULL)
+		return reply (out, "error", "cannot open database");
+
+	if (!trellis_map (m, in, out_path))
+		return reply (out, "error", trellis_map_error (m));
+
+	return reply (out, "ok", NULL);
+}
+
+static int on_request (struct service *o, char *line, FILE *out)
+{
+	char verb[16];
+	int n;
+
+	line[strcspn (line, "\r\n")] = '\0';
+
+	if (sscanf (line, "%15s%n", verb, &n) != 1)
+		return 1;  /* skip empty line */
+
+	if (strcmp (verb, "map") == 0)
+		return on_map (o, line + n, out);
+
+	return reply (out, "error", "unknown request");
+}
+
+static void serve (struct service *o, int fd)
+{
+	FILE *in, *out;
+	char *line = NULL;
+	size_t size = 0;
+
+	if ((in = fdopen (fd, "r")) == NULL) {
+		close (fd);
+		return;
+	}
+
+	if ((fd = dup (fd)) < 0 || (out = fdopen (fd, "w")) == NULL)
+		goto no_out;
+
+	while (getline (&line, &size, in) > 0)
+		if (!on_request (o, line, out))
+			break;
+
+	free (line);
+	fclose (out);
+	fclose (in);
+	return;
+no_out:
+	if (fd >= 0)
+		close (fd);
+
+	fclose (in);
+}
+
+static int listen_on (const char *path)
+{
+	struct sockaddr_un sa;
+	struct stat st;
+	int s;
+
+	if (strlen (path) >= sizeof (sa.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	memset (&sa, 0, sizeof (sa));
+	sa.sun_family = AF_UNIX;
+	strcpy (sa.sun_path, path);
+
+	if ((s = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+		return -1;
+
+	if (lstat (path, &st) == 0) {
+		if (!S_ISSOCK (st.st_mode)) {
+			errno = EEXIST;
+			goto error;
+		}
+
+		unlink (path);  /* remove stale socket */
+	}
+
+	if (bind (s, (struct sockaddr *) &sa, sizeof (sa)) != 0 ||
+	    listen (s, 16) != 0)
+		goto error;
+
+	return s;
+error:
+	close (s);
+	return -1;
+}
+
+int main (int argc, char *argv[])
+{
+	struct service o = {0, NULL};
+	int s, fd;
+
+	if (argc != 2)
+		errx (0, "\n\tdakota-mapd <socket>");
+
+	signal (SIGPIPE, SIG_IGN);
+	dakota_cache_prefetch (1);
+
+	if ((s = listen_on (argv[1])) < 0)
+		err (1, "cannot listen on %s", argv[1]);
+
+	for (;;) {
+		if ((fd = accept (s, NULL, NULL)) < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			err (1, "cannot accept connection");
+		}
+
+		serve (&o, fd);
+	}
+
+	return 0;
+}
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <dakota/alloc.h>
 #include <dakota/data/array.h>
 
 void *array_do_alloc (size_t count, size_t size)
@@ -19,7 +20,7 @@ void *array_do_alloc (size_t count, size_t size)
 		return NULL;
 	}
 
-	return malloc (size * count);
+	return dakota_alloc (ALLOC_ARRAY, size * count);
 }
 
 void *array_do_resize (void *o, size_t count, size_t size)
@@ -29,7 +30,34 @@ void *array_do_resize (void *o, size_t count, size_t size)
 		return NULL;
 	}
 
-	return realloc (o, size * count);
+	return dakota_realloc (ALLOC_ARRAY, o, size * count);
+}
+
+void *array_do_grow (void *o, size_t *max, size_t count, size_t size)
+{
+	size_t next = *max < 4 ? 4 : *max;
+
+	if (count <= *max)
+		return o;
+
+	while (next < count)
+		next = next > SIZE_MAX / 2 ? count : next * 2;
+
+	if ((o = array_do_resize (o, next, size)) != NULL)
+		*max = next;
+
+	return o;
+}
+
+void *array_do_shrink (void *o, size_t *max, size_t count, size_t size)
+{
+	if (count == 0 || count >= *max)
+		return o;
+
+	if ((o = array_do_resize (o, count, size)) != NULL)
+		*max = count;
+
+	return o;
 }
 
 void array_do_free (void *o, size_t count, size_t size, void (*free_entry) ())
@@ -40,5 +68,5 @@ void array_do_free (void *o, size_t count, size_t size, void (*free_entry) ())
 		for (i = 0, pos = 0; i < count; ++i, pos += size)
 			free_entry (o + pos);
 
-	free (o);
+	dakota_free (o);
 }
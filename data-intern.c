@@ -0,0 +1,128 @@
+/*
+ * Dakota String Interning
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/hash.h>
+#include <dakota/data/intern.h>
+
+/*
+ * Open addressing table with linear probing, kept at most half full;
+ * strings themselves are stored in arena
+ */
+void intern_init (struct intern_table *o)
+{
+	arena_init (&o->arena);
+	o->slot  = NULL;
+	o->count = o->size = 0;
+}
+
+void intern_fini (struct intern_table *o)
+{
+	dakota_free (o->slot);
+	arena_fini (&o->arena);
+}
+
+static size_t intern_slot (struct intern_table *o, const char *s, size_t hash)
+{
+	size_t i;
+
+	for (
+		i = hash & (o->size - 1);
+		o->slot[i] != NULL && strcmp (o->slot[i], s) != 0;
+		i = (i + 1) & (o->size - 1)
+	)
+		/* probe next */;
+
+	return i;
+}
+
+static int intern_grow (struct intern_table *o)
+{
+	const size_t next = o->size == 0 ? 1024 : o->size * 2;
+	const char **old = o->slot, **p, *s;
+	size_t old_size = o->size, i, hash;
+
+	if ((p = dakota_zalloc (ALLOC_INTERN, sizeof (p[0]) * next)) == NULL)
+		return 0;
+
+	o->slot = p;
+	o->size = next;
+
+	for (i = 0; i < old_size; ++i)
+		if ((s = old[i]) != NULL) {
+			hash = hash_string (HASH_INIT, s);
+			o->slot[intern_slot (o, s, hash)] = s;
+		}
+
+	dakota_free (old);
+	return 1;
+}
+
+static const char *intern_do (struct intern_table *o, const char *s, int copy)
+{
+	const size_t hash = hash_string (HASH_INIT, s);
+	size_t i;
+
+	if (o->size > 0 && o->slot[i = intern_slot (o, s, hash)] != NULL)
+		return o->slot[i];  /* known string: table is not touched */
+
+	if ((o->count + 1) * 2 > o->size && !intern_grow (o))
+		return NULL;
+
+	i = intern_slot (o, s, hash);
+
+	if ((o->slot[i] = copy ? arena_strdup (&o->arena, s) : s) == NULL)
+		return NULL;
+
+	++o->count;
+	return o->slot[i];
+}
+
+const char *intern_add (struct intern_table *o, const char *s)
+{
+	return intern_do (o, s, 1);
+}
+
+const char *intern_borrow (struct intern_table *o, const char *s)
+{
+	return intern_do (o, s, 0);
+}
+
+const char *intern_find (struct intern_table *o, const char *s)
+{
+	if (o->size == 0)
+		return NULL;
+
+	return o->slot[intern_slot (o, s, hash_string (HASH_INIT, s))];
+}
+
+static struct intern_table shared;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+const char *intern (const char *s)
+{
+	const char *p;
+
+	pthread_mutex_lock (&lock);
+	p = intern_add (&shared, s);
+	pthread_mutex_unlock (&lock);
+	return p;
+}
+
+const char *intern_lookup (const char *s)
+{
+	const char *p;
+
+	pthread_mutex_lock (&lock);
+	p = intern_find (&shared, s);
+	pthread_mutex_unlock (&lock);
+	return p;
+}
@@ -28,6 +28,21 @@ no_key:
 	return 0;
 }
 
+int pair_intern (struct pair *o, struct intern_table *t,
+		 const char *key, const char *value)
+{
+	if ((o->value = (char *) intern_add (t, value)) == NULL)
+		return 0;
+
+	if (key == NULL)
+		o->key = NULL;
+	else
+	if ((o->key = (char *) intern_add (t, key)) == NULL)
+		return 0;
+
+	return 1;
+}
+
 void pair_fini (struct pair *o)
 {
 	free (o->key);
@@ -0,0 +1,89 @@
+/*
+ * Dakota Segmented Sequence
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdint.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/seq.h>
+
+void seq_init (struct seq *o, size_t size)
+{
+	o->count = 0;
+	o->size  = size;
+	o->nsegs = 0;
+	o->seg   = NULL;
+}
+
+void seq_fini (struct seq *o, void (*free_entry) ())
+{
+	size_t i;
+
+	if (free_entry != NULL)
+		for (i = 0; i < o->count; ++i)
+			free_entry (seq_at (o, i));
+
+	for (i = 0; i < o->nsegs; ++i)
+		dakota_free (o->seg[i]);
+
+	dakota_free (o->seg);
+	seq_init (o, o->size);
+}
+
+/*
+ * Only the table of segments is reallocated, entries are never copied
+ */
+static int seq_grow (struct seq *o)
+{
+	const size_t k = o->nsegs;
+	char **seg;
+
+	if (k >= sizeof (size_t) * 8 - 5 ||
+	    (SIZE_MAX / o->size >> k) < SEQ_BASE) {
+		errno = ENOMEM;
+		return 0;
+	}
+
+	seg = dakota_realloc (ALLOC_ARRAY, o->seg, sizeof (seg[0]) * (k + 1));
+	if (seg == NULL)
+		return 0;
+
+	o->seg = seg;
+
+	if ((seg[k] = dakota_alloc (ALLOC_ARRAY,
+				    (o->size * SEQ_BASE) << k)) == NULL)
+		return 0;
+
+	o->nsegs = k + 1;
+	return 1;
+}
+
+void *seq_next (struct seq *o)
+{
+	if (seq_seg (o->count) >= o->nsegs && !seq_grow (o))
+		return NULL;
+
+	return seq_at (o, o->count);
+}
+
+size_t seq_index (const struct seq *o, const void *p)
+{
+	const uintptr_t q = (uintptr_t) p;
+	uintptr_t start;
+	size_t k, base, len;
+
+	for (k = 0, base = 0; k < o->nsegs; ++k, base += len) {
+		start = (uintptr_t) o->seg[k];
+		len   = SEQ_BASE << k;
+
+		if (q >= start && q < start + len * o->size)
+			return base + (q - start) / o->size;
+	}
+
+	return o->count;
+}
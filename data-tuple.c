@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/alloc.h>
 #include <dakota/data/array.h>
 #include <dakota/data/tuple.h>
 
@@ -61,3 +62,50 @@ void tuple_fini (struct tuple *o)
 {
 	array_free (o->m, o->size, tuple_entry_fini);
 }
+
+int tuple_intern_va (struct tuple *o, struct intern_table *t,
+		     size_t size, va_list ap)
+{
+	const char *value;
+	size_t i;
+
+	if ((o->m = array_alloc (o->m, size)) == NULL)
+		return 0;
+
+	for (i = 0; i < size; ++i)
+		if ((value = va_arg (ap, const char *)) == NULL ||
+		    (o->m[i] = (char *) intern_add (t, value)) == NULL)
+			goto no_value;
+
+	o->size = size;
+	return 1;
+no_value:
+	dakota_free (o->m);
+	return 0;
+}
+
+int tuple_intern_v (struct tuple *o, struct intern_table *t,
+		    size_t size, const char *argv[])
+{
+	const char *value;
+	size_t i;
+
+	if ((o->m = array_alloc (o->m, size)) == NULL)
+		return 0;
+
+	for (i = 0; i < size; ++i)
+		if ((value = argv[i]) == NULL ||
+		    (o->m[i] = (char *) intern_add (t, value)) == NULL)
+			goto no_value;
+
+	o->size = size;
+	return 1;
+no_value:
+	dakota_free (o->m);
+	return 0;
+}
+
+void tuple_intern_fini (struct tuple *o)
+{
+	dakota_free (o->m);
+}
@@ -0,0 +1,58 @@
+/*
+ * Dakota Memory Allocation
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_ALLOC_H
+#define DAKOTA_ALLOC_H  1
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Every allocation is charged to a subsystem, live and peak byte counts
+ * are kept per subsystem; ALLOC_COUNT as id selects totals.
+ */
+enum alloc_id {
+	ALLOC_BITMAP	= 0,
+	ALLOC_TILE	= 1,
+	ALLOC_CHIPLET	= 2,
+	ALLOC_MODEL	= 3,
+	ALLOC_SYMBOL	= 4,
+	ALLOC_ARRAY	= 5,
+	ALLOC_ARENA	= 6,
+	ALLOC_INTERN	= 7,
+
+	ALLOC_COUNT
+};
+
+/*
+ * Allocator hook: allocates new block if p is NULL, frees block p of the
+ * old size if size is zero, or resizes block p otherwise. The allocator
+ * must be set before the first allocation and must be thread-safe if
+ * library is used by several threads: model connect runs a pool of them.
+ */
+typedef void *dakota_alloc_fn (void *cookie, void *p, size_t old, size_t size);
+
+void dakota_set_allocator (dakota_alloc_fn *fn, void *cookie);
+
+/*
+ * Blocks start after a private header, thus they must be resized and
+ * freed with dakota_realloc and dakota_free only, never with realloc or
+ * free. This covers arrays of dakota/data/array.h as well.
+ */
+void *dakota_alloc   (int id, size_t size);
+void *dakota_zalloc  (int id, size_t size);
+void *dakota_realloc (int id, void *p, size_t size);
+void  dakota_free    (void *p);
+char *dakota_strdup  (int id, const char *s);
+
+size_t dakota_alloc_live (int id);
+size_t dakota_alloc_peak (int id);
+
+int dakota_alloc_report (FILE *out);
+
+#endif  /* DAKOTA_ALLOC_H */
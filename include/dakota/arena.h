@@ -0,0 +1,32 @@
+/*
+ * Dakota Memory Arena
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_ARENA_H
+#define DAKOTA_ARENA_H  1
+
+#include <stddef.h>
+
+/*
+ * Bump allocator for short-lived objects: blocks are never freed one by
+ * one, arena_reset releases all of them at once but keeps chunks for
+ * reuse, arena_fini returns chunks to the heap.
+ */
+struct arena {
+	struct arena_chunk *head, *chunk;
+	char *pos, *end;
+};
+
+void arena_init  (struct arena *o);
+void arena_fini  (struct arena *o);
+void arena_reset (struct arena *o);
+
+void *arena_alloc  (struct arena *o, size_t size);
+void *arena_zalloc (struct arena *o, size_t size);
+char *arena_strdup (struct arena *o, const char *s);
+
+#endif  /* DAKOTA_ARENA_H */
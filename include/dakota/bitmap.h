@@ -11,6 +11,7 @@
 
 #include <stddef.h>
 
+#include <dakota/arena.h>
 #include <dakota/chip-bits.h>
 
 struct bitmap {
@@ -19,14 +20,23 @@ struct bitmap {
 
 	unsigned char *bits;
 	unsigned char *mask;
+
+	struct arena *arena;	/* storage owner, NULL for heap */
 };
 
 struct bitmap *bitmap_alloc (void);
-struct bitmap *bitmap_clone (const struct bitmap *o);
+/*
+ * Clone into arena if it is not NULL: such bitmap and its planes live
+ * until arena reset and bitmap_free does nothing for it
+ */
+struct bitmap *bitmap_clone (const struct bitmap *o, struct arena *arena);
 void bitmap_free (struct bitmap *o);
+void bitmap_clear (struct bitmap *o);
 
 int bitmap_resize (struct bitmap *o, size_t x, size_t y);
 
+void bitmap_erase (struct bitmap *o, size_t x, size_t y, size_t w, size_t h);
+
 int  bitmap_add (struct bitmap *o, size_t x, size_t y, int value);
 void bitmap_sub (struct bitmap *o, size_t x, size_t y);
 
@@ -16,4 +16,20 @@ struct cmdb *dakota_open_tiles (const char *family, const char *mode);
 struct cmdb *
 dakota_open_grid (const char *family, const char *device, const char *mode);
 
+/*
+ * Databases are cached: repeated open with the same family, device and
+ * mode returns the same handle. Every successful open must be paired with
+ * dakota_close, the database is really closed when the last reference is
+ * dropped. Returns the status of cmdb_close or 1 if database still in use.
+ * Open and close may be called from any thread, but the shared handle
+ * itself is not locked: users in different threads must not use it at
+ * the same time.
+ */
+int dakota_close (struct cmdb *db);
+
+/*
+ * Enable or disable read-ahead of database files on open.
+ */
+void dakota_cache_prefetch (int enable);
+
 #endif  /* DAKOTA_CACHE_H */
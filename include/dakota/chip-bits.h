@@ -11,6 +11,8 @@
 
 #include <stdio.h>
 
+#include <dakota/arena.h>
+
 #ifndef assert
 #define assert(e)
 #endif
@@ -50,9 +52,17 @@ static inline unsigned chip_bit_invert (unsigned bit)
 }
 
 int chip_bit_parse (const char *s);
-unsigned *chip_bits_parse (const char *s);
+/*
+ * Parse bit list into arena if it is not NULL or into heap otherwise
+ */
+unsigned *chip_bits_parse (const char *s, struct arena *arena);
 char *chip_bits_string (const unsigned *bits);
 
+/*
+ * Extend width and height to cover every bit of the list s
+ */
+void chip_bits_extent (const char *s, size_t *width, size_t *height);
+
 void chip_bits_invert (unsigned *bits);
 
 int chip_bit_read (FILE *in);
@@ -14,6 +14,7 @@
 
 struct chip *chip_alloc (struct cmdb *tiles, struct cmdb *grid);
 void chip_free (struct chip *o);
+void chip_reset (struct chip *o);
 
 int chip_add_grid (struct chip *o, struct cmdb *grid);
 int chip_add_tile (struct chip *o, const char *name, const char *type);
@@ -25,6 +26,12 @@ int chip_set_enum (struct chip *o, const char *name, const char *value);
 
 int chip_commit (struct chip *o);
 
+/*
+ * Commit pending tiles into separate bitmap instead of chip image, x and
+ * y are set to position of returned bitmap in chip image
+ */
+struct bitmap *chip_commit_apart (struct chip *o, size_t *x, size_t *y);
+
 const struct bitmap *chip_get_bits (const struct chip *o);
 
 #endif  /* DAKOTA_CHIP_H */
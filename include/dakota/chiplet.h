@@ -10,9 +10,15 @@
 #define DAKOTA_CHIPLET_H  1
 
 #include <cmdb.h>
+#include <dakota/arena.h>
 #include <dakota/bitmap.h>
 
-struct chiplet *chiplet_alloc (struct cmdb *db);
+/*
+ * Pending tiles are allocated from arena, chiplet_reset forgets them and
+ * the owner should reset arena after it. If arena is NULL pending tiles
+ * are allocated from the heap and chiplet_reset frees them.
+ */
+struct chiplet *chiplet_alloc (struct cmdb *db, struct arena *arena);
 void chiplet_reset (struct chiplet *o);
 void chiplet_free  (struct chiplet *o);
 
@@ -23,6 +29,14 @@ int chiplet_set_mux  (struct chiplet *o, const char *name, const char *source);
 int chiplet_set_word (struct chiplet *o, const char *name, const char *value);
 int chiplet_set_enum (struct chiplet *o, const char *name, const char *value);
 
-int chiplet_blit (const struct chiplet *o, struct bitmap *image);
+/*
+ * Blit tiles into image, chiplet_blit_at places tiles relative to the
+ * point x, y, which should not be greater than chiplet origin
+ */
+void chiplet_origin (const struct chiplet *o, size_t *x, size_t *y);
+
+int chiplet_blit    (const struct chiplet *o, struct bitmap *image);
+int chiplet_blit_at (const struct chiplet *o, struct bitmap *image,
+		     size_t x, size_t y);
 
 #endif  /* DAKOTA_CHIPLET_H */
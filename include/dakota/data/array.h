@@ -11,6 +11,11 @@
 
 #include <stddef.h>
 
+/*
+ * Arrays are allocated with dakota_alloc and charged to ALLOC_ARRAY: they
+ * must be resized and freed with array functions or dakota_realloc and
+ * dakota_free, but never with realloc or free.
+ */
 void *array_do_alloc (size_t count, size_t size);
 
 void *array_do_resize (void *o, size_t count, size_t size);
@@ -25,4 +30,19 @@ void array_do_free (void *o, size_t count, size_t size, void (*free_entry) ());
 #define array_free(array, count, free_entry) \
 	array_do_free (array, count, sizeof (array[0]), free_entry)
 
+/*
+ * Growable array with capacity kept in max: array_grow makes room for
+ * count entries doubling capacity as required, array_shrink drops unused
+ * capacity. Both return new array or NULL on error, the array is kept
+ * intact in the latter case.
+ */
+void *array_do_grow   (void *o, size_t *max, size_t count, size_t size);
+void *array_do_shrink (void *o, size_t *max, size_t count, size_t size);
+
+#define array_grow(array, max, count) \
+	array_do_grow (array, &(max), count, sizeof (array[0]))
+
+#define array_shrink(array, max, count) \
+	array_do_shrink (array, &(max), count, sizeof (array[0]))
+
 #endif /* DAKOTA_DATA_ARRAY_H */
@@ -0,0 +1,53 @@
+/*
+ * Dakota Hash Helpers
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_DATA_HASH_H
+#define DAKOTA_DATA_HASH_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * FNV-1a, to hash a sequence of items pass result of previous call as
+ * initial value for the next one.
+ */
+#define HASH_INIT  0xcbf29ce484222325ULL
+
+static inline uint64_t hash_data (uint64_t h, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < size; ++i)
+		h = (h ^ p[i]) * 0x100000001b3ULL;
+
+	return h;
+}
+
+static inline uint64_t hash_string (uint64_t h, const char *s)
+{
+	for (; *s != '\0'; ++s)
+		h = (h ^ (unsigned char) *s) * 0x100000001b3ULL;
+
+	return h * 0x100000001b3ULL;  /* mix in terminator */
+}
+
+/*
+ * Mix pointer bits, for use with interned strings and other unique keys
+ */
+static inline uint64_t hash_pointer (const void *p)
+{
+	uint64_t h = (uintptr_t) p;
+
+	h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+	h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+
+	return h ^ (h >> 33);
+}
+
+#endif  /* DAKOTA_DATA_HASH_H */
@@ -0,0 +1,50 @@
+/*
+ * Dakota String Interning
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_DATA_INTERN_H
+#define DAKOTA_DATA_INTERN_H  1
+
+#include <stddef.h>
+
+#include <dakota/arena.h>
+
+/*
+ * Table of interned strings: equal strings are interned into the same
+ * pointer, thus strings interned into one table are compared by pointer.
+ * Interned strings are immutable and live until the table is finalized.
+ *
+ * The intern_add returns interned copy of s, adding it if required; the
+ * intern_find returns NULL if s was never interned, thus no interned name
+ * can match it. The intern_borrow adds s itself, not a copy of it, thus s
+ * must outlive the table.
+ *
+ * Table is not locked, but intern of known string does not modify it,
+ * thus threads may intern known strings and look up concurrently.
+ */
+struct intern_table {
+	struct arena arena;
+	const char **slot;
+	size_t count, size;
+};
+
+void intern_init (struct intern_table *o);
+void intern_fini (struct intern_table *o);
+
+const char *intern_add  (struct intern_table *o, const char *s);
+const char *intern_find (struct intern_table *o, const char *s);
+const char *intern_borrow (struct intern_table *o, const char *s);
+
+/*
+ * Shared table for small vocabularies of chip databases, tile types and
+ * tile names: it lives until the process exits and is locked. Names of
+ * models are interned into the table of the model tree.
+ */
+const char *intern (const char *s);
+const char *intern_lookup (const char *s);
+
+#endif  /* DAKOTA_DATA_INTERN_H */
@@ -11,6 +11,8 @@
 
 #include <stddef.h>
 
+#include <dakota/data/intern.h>
+
 struct pair {
 	char *key, *value;
 };
@@ -18,4 +20,11 @@ struct pair {
 int  pair_init (struct pair *o, const char *key, const char *value);
 void pair_fini (struct pair *o);
 
+/*
+ * Pair of strings interned into table: the table owns them, thus such
+ * pair is not finalized and its strings must not be modified
+ */
+int pair_intern (struct pair *o, struct intern_table *t,
+		 const char *key, const char *value);
+
 #endif  /* DAKOTA_DATA_PAIR_H */
@@ -0,0 +1,67 @@
+/*
+ * Dakota Segmented Sequence
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_DATA_SEQ_H
+#define DAKOTA_DATA_SEQ_H  1
+
+#include <stddef.h>
+
+/*
+ * Sequence of fixed size entries kept in segments of doubling capacity:
+ * segment k holds SEQ_BASE << k entries. Entries never move, thus pointers
+ * to them stay valid until the sequence is finalized, append is O(1) and
+ * never copies entries, and lookup by index is O(1).
+ */
+#define SEQ_BASE  16
+
+struct seq {
+	size_t count, size;	/* entries used, entry size */
+	size_t nsegs;
+	char **seg;
+};
+
+void seq_init (struct seq *o, size_t size);
+void seq_fini (struct seq *o, void (*free_entry) ());
+
+/*
+ * The seq_next returns storage for the entry at index count, or NULL on
+ * error; the entry is added to sequence by seq_commit after it is
+ * initialized successfully.
+ */
+void *seq_next (struct seq *o);
+
+static inline void seq_commit (struct seq *o)
+{
+	++o->count;
+}
+
+static inline size_t seq_seg (size_t i)
+{
+	const size_t t = i / SEQ_BASE + 1;
+
+	return sizeof (long long) * 8 - 1 - __builtin_clzll (t);
+}
+
+static inline void *seq_at (const struct seq *o, size_t i)
+{
+	const size_t k = seq_seg (i);
+
+	return o->seg[k] + (i - SEQ_BASE * ((1ULL << k) - 1)) * o->size;
+}
+
+/*
+ * Index of entry p, or count if p is not an entry of the sequence
+ */
+size_t seq_index (const struct seq *o, const void *p);
+
+static inline void *seq_last (const struct seq *o)
+{
+	return o->count == 0 ? NULL : seq_at (o, o->count - 1);
+}
+
+#endif  /* DAKOTA_DATA_SEQ_H */
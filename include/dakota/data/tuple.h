@@ -12,6 +12,8 @@
 #include <stdarg.h>
 #include <stddef.h>
 
+#include <dakota/data/intern.h>
+
 struct tuple {
 	size_t size;
 	char **m;
@@ -21,4 +23,14 @@ int  tuple_init_va (struct tuple *o, size_t size, va_list ap);
 int  tuple_init_v  (struct tuple *o, size_t size, const char *argv[]);
 void tuple_fini    (struct tuple *o);
 
+/*
+ * Tuple of strings interned into table: the table owns them, thus the
+ * tuple_intern_fini frees the tuple array only
+ */
+int  tuple_intern_va (struct tuple *o, struct intern_table *t,
+		      size_t size, va_list ap);
+int  tuple_intern_v  (struct tuple *o, struct intern_table *t,
+		      size_t size, const char *argv[]);
+void tuple_intern_fini (struct tuple *o);
+
 #endif  /* DAKOTA_DATA_TUPLE_H */
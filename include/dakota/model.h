@@ -21,6 +21,26 @@ const char *model_status (struct model *o);
 struct model *model_read (const char *path);
 int model_write (struct model *o, const char *path);
 
+/*
+ * Text model is produced in large chunks and passed to sink, the sink
+ * returns zero and sets errno on failure, this stops the writer
+ */
+typedef int model_sink_fn (void *cookie, const void *data, size_t size);
+
+int model_write_sink (struct model *o, model_sink_fn *sink, void *cookie);
+
+/*
+ * Binary form of committed model for fast reload: strings are stored
+ * once, ports are stored as connect resolved them, thus load is not
+ * parsed nor connected again. File is valid only for the same version
+ * and byte order. Loaded model keeps the file mapped and takes strings
+ * from it, thus the file must not be truncated until model is freed.
+ * The model_load_binary returns NULL and sets errno on failure, EINVAL
+ * for wrong file.
+ */
+struct model *model_load_binary (const char *path);
+int model_write_binary (struct model *o, const char *path);
+
 int model_add_input    (struct model *o, const char *name);
 int model_add_output   (struct model *o, const char *name);
 int model_add_wire     (struct model *o, const char *sink, const char *source);
@@ -29,6 +49,17 @@ int model_add_bind     (struct model *o, const char *port, const char *value);
 int model_add_model    (struct model *o, const char *name);
 
 const char *model_get_cell (struct model *o);
+struct model *model_get_model (struct model *o, const char *name);
+
+/*
+ * Expand cells of other models recursively into new model of tables and
+ * latches: every model is flattened once and copied to its instances.
+ * Nets and cells of instance X are named X/name, params of instances go
+ * to the flat model as X/param unless they are given by name of param of
+ * enclosing model, then they are wired to that param. The model must be
+ * committed successfully. Returns NULL and sets model error on failure.
+ */
+struct model *model_flatten (struct model *o);
 
 /*
  * model aoi22
@@ -11,23 +11,31 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include <dakota/bitmap.h>
+#include <dakota/data/intern.h>
 #include <dakota/data/pair.h>
 #include <dakota/data/tuple.h>
 
 struct cell {
-	char *type, *name;
+	const char *type, *name;	/* interned into names */
 
 	size_t       nbinds, nparams, nattrs, ntuples;
+	size_t       maxbinds, maxparams, maxattrs, maxtuples;
 	struct pair  *bind,  *param,  *attr;
 	struct tuple *tuple;
 
 	struct bitmap *map;
+	uint64_t *lut;		/* cached truth table, see cell_get_lut */
+
+	struct intern_table *strings;	/* owner of strings, NULL if cell */
 };
 
-int  cell_init (struct cell *o, const char *type, const char *name);
+int  cell_init (struct cell *o, struct intern_table *names,
+		const char *type, const char *name);
 void cell_fini (struct cell *o);
+void cell_shrink (struct cell *o);
 
 int cell_add_bind     (struct cell *o, const char *port, const char *value);
 int cell_add_param    (struct cell *o, const char *name, const char *value);
@@ -41,4 +49,15 @@ int cell_load_bitmap  (struct cell *o, const char *path);
 
 const char *cell_get_attr (const struct cell *o, const char *name);
 
+/*
+ * Truth table of table cell with at most CELL_LUT_INPUTS inputs, one mask
+ * per output: bit i of mask is output value for input k equal to bit k of
+ * i. It is built on first use and cached on cell until cell is changed.
+ * Returns NULL and sets errno to ERANGE for larger tables, to EINVAL for
+ * other cells or wrong rows.
+ */
+#define CELL_LUT_INPUTS  6
+
+const uint64_t *cell_get_lut (struct cell *o);
+
 #endif  /* DAKOTA_MODEL_CELL_H */
@@ -0,0 +1,74 @@
+/*
+ * Dakota Compiled Netlist
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_MODEL_NETLIST_H
+#define DAKOTA_MODEL_NETLIST_H  1
+
+#include <stddef.h>
+
+/*
+ * Flat form of connected model for fast traversal: structure of arrays
+ * indexed by net, cell and pin ids. Nets are ports of the model, pins of
+ * a cell and loads of a net are kept contiguous in CSR form: pins of cell
+ * c are cell_pin[c] .. cell_pin[c + 1] - 1, load pins of net n are
+ * load[net_load[n]] .. load[net_load[n + 1] - 1].
+ */
+#define NL_NONE  ((size_t) -1)
+
+enum netlist_kind {
+	NL_TABLE,		/* .names or .table, pin port is column	*/
+	NL_LATCH,		/* pin port is NL_LATCH_*		*/
+	NL_SUBCKT,		/* pin port is port of cell model	*/
+};
+
+enum netlist_latch {
+	NL_LATCH_D,
+	NL_LATCH_Q,
+	NL_LATCH_C,
+};
+
+enum netlist_dir {
+	NL_IN,
+	NL_OUT,
+};
+
+struct netlist {
+	struct model *model;
+
+	size_t nnets;
+	const char  **net_name;		/* interned port names		*/
+	int          *net_type;		/* port type flags		*/
+	size_t       *net_driver;	/* pin, NL_NONE if driven by port */
+	size_t       *net_load;		/* nnets + 1 offsets into load	*/
+	size_t       *load;		/* load pins			*/
+
+	size_t ncells;
+	struct cell  **cell;
+	struct model **cell_model;	/* NULL for tables and latches	*/
+	unsigned char *cell_kind;
+	size_t        *cell_pin;	/* ncells + 1 offsets into pins	*/
+
+	size_t npins;
+	size_t        *pin_net;
+	size_t        *pin_cell;
+	size_t        *pin_port;
+	unsigned char *pin_dir;
+};
+
+/*
+ * Compile connected model: the model must be committed successfully and
+ * must be kept intact while netlist is in use. Returns NULL and sets
+ * model error on failure. The netlist_get_net returns NL_NONE if there
+ * is no net with the given name.
+ */
+struct netlist *netlist_alloc (struct model *m);
+void netlist_free (struct netlist *o);
+
+size_t netlist_get_net (struct netlist *o, const char *name);
+
+#endif  /* DAKOTA_MODEL_NETLIST_H */
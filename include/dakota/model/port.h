@@ -11,6 +11,8 @@
 
 #include <stddef.h>
 
+#include <dakota/data/intern.h>
+
 enum port_type {
 	PORT_INPUT	= 1,	/* port is model input			*/
 	PORT_DRIVEN	= 2,	/* port has driver: connected to source	*/
@@ -18,15 +20,15 @@ enum port_type {
 };
 
 struct port {
-	char *name;
+	const char *name;	/* interned into names */
 	int type;
 
 	struct cell *cell;	/* binded cell      */
 	size_t ref;		/* binded cell port */
 };
 
-int  port_init (struct port *o, const char *name, int type,
-		struct cell *cell, size_t ref);
+int  port_init (struct port *o, struct intern_table *names, const char *name,
+		int type, struct cell *cell, size_t ref);
 void port_fini (struct port *o);
 
 #endif  /* DAKOTA_MODEL_PORT_H */
@@ -0,0 +1,52 @@
+/*
+ * Dakota Model Reader
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_MODEL_READER_H
+#define DAKOTA_MODEL_READER_H  1
+
+#include <stddef.h>
+
+/*
+ * Model text is passed to actions command by command, nothing is kept
+ * between commands. Cell kind is the command name without dot, type of
+ * table cell is "table" and type of latch cell is "latch". Port of bind
+ * and value of param or attribute are NULL when not given. Strings are
+ * valid during call only. Actions may be NULL to skip commands, action
+ * returns zero to stop reader.
+ */
+struct model_action {
+	int (*on_model)  (void *o, const char *name);
+	int (*on_input)  (void *o, const char *name);
+	int (*on_output) (void *o, const char *name);
+
+	int (*on_cell)   (void *o, const char *kind, const char *type);
+	int (*on_bind)   (void *o, const char *port, const char *value);
+	int (*on_tuple)  (void *o, size_t argc, const char **argv);
+
+	int (*on_cname)  (void *o, const char *name);
+	int (*on_param)  (void *o, const char *name, const char *value);
+	int (*on_attr)   (void *o, const char *name, const char *value);
+};
+
+struct model_reader {
+	const struct model_action *action;
+	void *cookie;
+
+	size_t lineno;		/* line of last command */
+	char error[256];	/* empty if action failed */
+};
+
+int model_reader_error (struct model_reader *o, const char *fmt, ...);
+
+/*
+ * Returns zero and sets errno if file cannot be read, or sets error on
+ * syntax error, or leaves error empty if action failed
+ */
+int model_parse (struct model_reader *o, const char *path);
+
+#endif  /* DAKOTA_MODEL_READER_H */
@@ -0,0 +1,38 @@
+/*
+ * Dakota Bit-Parallel Model Simulator
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_MODEL_SIM_H
+#define DAKOTA_MODEL_SIM_H  1
+
+#include <stdint.h>
+
+#include <dakota/model/netlist.h>
+
+/*
+ * Simulator runs 64 test vectors at once, one per bit of net value.
+ * Table cells are levelized and compiled into sum of products over net
+ * values, or into truth table lookups for small dense tables, latches
+ * break combinational paths and all of them are clocked once per cycle.
+ * Model must be flat: cells of other models are not supported.
+ *
+ * Nets driven by params are set from param values (net name[i] gets
+ * character i of value) on reset, latches get their init value, other
+ * nets are cleared. The sim_eval propagates inputs through combinational
+ * logic, the sim_step latches data inputs and evaluates results.
+ */
+struct sim *sim_alloc (struct netlist *nl);
+void sim_free  (struct sim *o);
+void sim_reset (struct sim *o);
+
+void     sim_set (struct sim *o, size_t net, uint64_t value);
+uint64_t sim_get (const struct sim *o, size_t net);
+
+void sim_eval (struct sim *o);
+void sim_step (struct sim *o);
+
+#endif  /* DAKOTA_MODEL_SIM_H */
@@ -0,0 +1,72 @@
+/*
+ * Dakota Statistics
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef DAKOTA_STATS_H
+#define DAKOTA_STATS_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Every probe counts spans, time spent in them and amount of processed
+ * items: records, lookups or bytes. Probes cost one flag check when
+ * statistics disabled at run time, and removed completely when library
+ * built with DAKOTA_NO_STATS defined.
+ */
+enum stats_id {
+	STATS_READ	= 0,	/* config read with actions, records */
+	STATS_LOOKUP	= 1,	/* tile and grid database lookups */
+	STATS_TILE	= 2,	/* tile prototype resolution, tiles */
+	STATS_RESIZE	= 3,	/* bitmap reallocation, bytes copied */
+	STATS_BLIT	= 4,	/* bitmap blit, bytes */
+	STATS_EXPORT	= 5,	/* bitmap export, bytes */
+
+	STATS_COUNT
+};
+
+#ifndef DAKOTA_NO_STATS
+
+extern int stats_enabled;
+
+uint64_t stats_clock (void);
+void stats_commit (int id, uint64_t start, size_t n);
+
+static inline uint64_t stats_begin (void)
+{
+	return stats_enabled ? stats_clock () : 0;
+}
+
+static inline void stats_end (int id, uint64_t start, size_t n)
+{
+	if (stats_enabled)
+		stats_commit (id, start, n);
+}
+
+#else  /* DAKOTA_NO_STATS */
+
+static inline uint64_t stats_begin (void)
+{
+	return 0;
+}
+
+static inline void stats_end (int id, uint64_t start, size_t n) {}
+
+#endif  /* DAKOTA_NO_STATS */
+
+/*
+ * Enable statistics collection, with trace set spans recorded as well
+ * to be saved later in Chrome trace event format
+ */
+void stats_enable (int trace);
+void stats_reset  (void);
+
+int stats_report (FILE *out);
+int stats_write_trace (const char *path);
+
+#endif  /* DAKOTA_STATS_H */
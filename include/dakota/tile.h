@@ -13,6 +13,13 @@
 #include <dakota/bitmap.h>
 
 struct tile *tile_alloc (struct cmdb *db, const char *type);
+
+/*
+ * Clone into arena if it is not NULL: such tile lives until arena reset,
+ * bit lists for it are parsed into the same arena, and tile_free does
+ * nothing for it
+ */
+struct tile *tile_clone (const struct tile *o, struct arena *arena);
 void tile_free (struct tile *o);
 
 int tile_set_raw  (struct tile *o, const unsigned *bits);
@@ -20,6 +27,7 @@ int tile_set_mux  (struct tile *o, const char *name, const char *source);
 int tile_set_word (struct tile *o, const char *name, const char *value);
 int tile_set_enum (struct tile *o, const char *name, const char *value);
 
+const char *tile_get_type (const struct tile *o);
 const struct bitmap *tile_get_bits (const struct tile *o);
 
 #endif  /* DAKOTA_TILE_H */
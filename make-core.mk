@@ -76,8 +76,6 @@ $(foreach F,$(HEADERS),$(eval $(call install-header,$(F))))
 all:     build-static
 install: install-static
 
-$(OBJECTS): CFLAGS += -I$(CURDIR)/include
-
 $(PCFILE):
 	@test -n "$(DESCRIPTION)" && echo "Description: $(DESCRIPTION)"	>  $@
 	@test -n "$(URL)" && echo "URL: $(URL)"		>> $@
@@ -100,6 +98,8 @@ AFILE	= bundle.a
 
 endif  # LIBNAME
 
+$(OBJECTS): CFLAGS += -I$(CURDIR)/include
+
 $(AFILE): $(OBJECTS)
 
 build-static: $(AFILE)
@@ -0,0 +1,596 @@
+/*
+ * Dakota Binary Model Format
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+#include <dakota/model.h>
+
+#include "model-core.h"
+
+/*
+ * File is header, string offsets, string data padded to word, and model
+ * records, all in host byte order. Every string is stored once and is
+ * referenced by index, BIN_NONE is NULL key of pair. Model record is
+ *
+ *	name, nparams, { key, value } ...,
+ *	ncells, { type, name, nbinds, { key, value } ...,
+ *		  nparams, { key, value } ..., nattrs, { key, value } ...,
+ *		  ntuples, { size, string ... } ... } ...,
+ *	nports, { name, type, cell, ref } ...,
+ *	nmodels, model ...
+ *
+ * where ports are stored as connect leaves them, cell is cell index or
+ * BIN_NONE, thus connect is not run on load.
+ */
+#define BIN_MAGIC	"DKMODEL"
+#define BIN_VERSION	1
+#define BIN_ORDER	0x01020304
+#define BIN_NONE	((uint32_t) -1)
+
+struct bin_head {
+	char     magic[8];
+	uint32_t version;
+	uint32_t order;		/* BIN_ORDER in byte order of writer */
+	uint32_t nstrings;
+	uint32_t strsize;	/* bytes of string data with padding */
+	uint64_t nwords;	/* words of model records */
+};
+
+struct bin_slot {
+	uint32_t hash, index;	/* index of string + 1, zero is empty */
+};
+
+struct bin_writer {
+	size_t nstrings, maxstrings, strsize;
+	const char **string;
+	size_t nslots;
+	struct bin_slot *slot;
+	size_t nwords, maxwords;
+	uint32_t *word;
+};
+
+static int bin_put (struct bin_writer *o, size_t x)
+{
+	uint32_t *p;
+
+	if (x > UINT32_MAX) {
+		errno = EOVERFLOW;
+		return 0;
+	}
+
+	if ((p = array_grow (o->word, o->maxwords, o->nwords + 1)) == NULL)
+		return 0;
+
+	o->word = p;
+	o->word[o->nwords++] = x;
+	return 1;
+}
+
+/*
+ * String index: open addressing hash of string contents with linear
+ * probing, kept at most half full. Hash is kept in slot, thus strings
+ * are compared only when hashes match.
+ */
+static struct bin_slot *
+bin_slot (struct bin_writer *o, const char *s, uint32_t hash)
+{
+	const size_t mask = o->nslots - 1;
+	struct bin_slot *p;
+	size_t i;
+
+	for (
+		i = hash & mask;
+		(p = o->slot + i)->index != 0 &&
+		(p->hash != hash || strcmp (o->string[p->index - 1], s) != 0);
+		i = (i + 1) & mask
+	)
+		/* probe next */;
+
+	return p;
+}
+
+static uint32_t bin_hash (const char *s)
+{
+	const uint64_t h = hash_string (HASH_INIT, s);
+
+	return h ^ (h >> 32);
+}
+
+static int bin_reindex (struct bin_writer *o)
+{
+	const size_t nslots = o->nslots == 0 ? 1024 : o->nslots * 2;
+	struct bin_slot *slot, *old = o->slot;
+	size_t i, j;
+
+	if ((slot = dakota_zalloc (ALLOC_MODEL,
+				   sizeof (slot[0]) * nslots)) == NULL)
+		return 0;
+
+	for (i = 0; i < o->nslots; ++i)
+		if (old[i].index != 0) {
+			for (
+				j = old[i].hash & (nslots - 1);
+				slot[j].index != 0;
+				j = (j + 1) & (nslots - 1)
+			)
+				/* probe next */;
+
+			slot[j] = old[i];
+		}
+
+	dakota_free (old);
+	o->slot   = slot;
+	o->nslots = nslots;
+	return 1;
+}
+
+static int bin_put_string (struct bin_writer *o, const char *s)
+{
+	const char **p;
+	struct bin_slot *slot;
+	uint32_t hash;
+
+	if (s == NULL)
+		return bin_put (o, BIN_NONE);
+
+	if ((o->nstrings + 1) * 2 > o->nslots && !bin_reindex (o))
+		return 0;
+
+	if ((slot = bin_slot (o, s, hash = bin_hash (s)))->index != 0)
+		return bin_put (o, slot->index - 1);
+
+	if (o->nstrings >= BIN_NONE ||
+	    (p = array_grow (o->string, o->maxstrings, o->nstrings + 1))
+	    == NULL)
+		return 0;
+
+	o->string = p;
+	o->string[o->nstrings] = s;
+	o->strsize += strlen (s) + 1;
+	slot->hash  = hash;
+	slot->index = ++o->nstrings;
+	return bin_put (o, o->nstrings - 1);
+}
+
+static int bin_put_pairs (struct bin_writer *o, const struct pair *p,
+			  size_t count)
+{
+	size_t i;
+	int ok = 1;
+
+	ok &= bin_put (o, count);
+
+	for (i = 0; ok && i < count; ++i) {
+		ok &= bin_put_string (o, p[i].key);
+		ok &= bin_put_string (o, p[i].value);
+	}
+
+	return ok;
+}
+
+static int bin_put_cell (struct bin_writer *o, const struct cell *c)
+{
+	const struct tuple *t;
+	size_t i, j;
+	int ok = 1;
+
+	ok &= bin_put_string (o, c->type);
+	ok &= bin_put_string (o, c->name);
+	ok &= bin_put_pairs (o, c->bind,  c->nbinds);
+	ok &= bin_put_pairs (o, c->param, c->nparams);
+	ok &= bin_put_pairs (o, c->attr,  c->nattrs);
+	ok &= bin_put (o, c->ntuples);
+
+	for (i = 0; ok && i < c->ntuples; ++i) {
+		t = c->tuple + i;
+		ok &= bin_put (o, t->size);
+
+		for (j = 0; ok && j < t->size; ++j)
+			ok &= bin_put_string (o, t->m[j]);
+	}
+
+	return ok;
+}
+
+static int bin_put_port (struct bin_writer *o, const struct model *m,
+			 const struct port *p)
+{
+	int ok = 1;
+
+	ok &= bin_put_string (o, p->name);
+	ok &= bin_put (o, p->type);
+	ok &= bin_put (o, p->cell == NULL ? BIN_NONE :
+			  seq_index (&m->cell, p->cell));
+	ok &= bin_put (o, p->ref);
+
+	return ok;
+}
+
+static int bin_put_model (struct bin_writer *o, const struct model *m)
+{
+	size_t i;
+	int ok = 1;
+
+	ok &= bin_put_string (o, m->name);
+	ok &= bin_put_pairs (o, m->param, m->nparams);
+	ok &= bin_put (o, m->cell.count);
+
+	for (i = 0; ok && i < m->cell.count; ++i)
+		ok &= bin_put_cell (o, model_cell (m, i));
+
+	ok &= bin_put (o, m->port.count);
+
+	for (i = 0; ok && i < m->port.count; ++i)
+		ok &= bin_put_port (o, m, model_port (m, i));
+
+	ok &= bin_put (o, m->model.count);
+
+	for (i = 0; ok && i < m->model.count; ++i)
+		ok &= bin_put_model (o, model_sub (m, i));
+
+	return ok;
+}
+
+static int bin_save (struct bin_writer *o, FILE *out)
+{
+	static const char pad[4];
+	struct bin_head h = { BIN_MAGIC, BIN_VERSION, BIN_ORDER };
+	uint32_t offset;
+	size_t i, len;
+	int ok = 1;
+
+	h.nstrings = o->nstrings;
+	h.strsize  = (o->strsize + 3) & ~(size_t) 3;
+	h.nwords   = o->nwords;
+
+	if (h.strsize < o->strsize) {
+		errno = EOVERFLOW;
+		return 0;
+	}
+
+	ok &= fwrite (&h, sizeof (h), 1, out) == 1;
+
+	for (i = 0, offset = 0; ok && i < o->nstrings; ++i) {
+		ok &= fwrite (&offset, sizeof (offset), 1, out) == 1;
+		offset += strlen (o->string[i]) + 1;
+	}
+
+	for (i = 0; ok && i < o->nstrings; ++i) {
+		len = strlen (o->string[i]) + 1;
+		ok &= fwrite (o->string[i], len, 1, out) == 1;
+	}
+
+	if (ok && h.strsize > o->strsize)
+		ok &= fwrite (pad, h.strsize - o->strsize, 1, out) == 1;
+
+	if (ok && o->nwords > 0)
+		ok &= fwrite (o->word, sizeof (o->word[0]), o->nwords, out) ==
+		      o->nwords;
+
+	return ok;
+}
+
+int model_write_binary (struct model *o, const char *path)
+{
+	struct bin_writer w = { 0 };
+	FILE *out;
+	int ok;
+
+	if ((ok = bin_put_model (&w, o))) {
+		if ((out = fopen (path, "wb")) == NULL)
+			ok = 0;
+		else {
+			ok = bin_save (&w, out);
+			ok &= fclose (out) == 0;
+		}
+	}
+
+	if (!ok)
+		model_error (o, NULL);
+
+	dakota_free (w.string);
+	dakota_free (w.slot);
+	dakota_free (w.word);
+	return ok;
+}
+
+/*
+ * Reader takes strings in place from the mapped file and fails softly:
+ * on wrong data it returns zero words and empty strings, and ok is
+ * checked once model is built
+ */
+struct bin_reader {
+	const uint32_t *word, *end;
+	const uint32_t *offset;
+	const char *data;
+	size_t nstrings, strsize;
+	int ok;
+};
+
+static uint32_t bin_get (struct bin_reader *o)
+{
+	if (o->word >= o->end) {
+		o->ok = 0;
+		return 0;
+	}
+
+	return *o->word++;
+}
+
+static const char *bin_get_string (struct bin_reader *o, int null)
+{
+	const uint32_t i = bin_get (o);
+
+	if (null && i == BIN_NONE)
+		return NULL;
+
+	if (i >= o->nstrings || o->offset[i] >= o->strsize) {
+		o->ok = 0;
+		return "";
+	}
+
+	return o->data + o->offset[i];
+}
+
+/*
+ * Count of entries of size words each, no more than left in file
+ */
+static size_t bin_get_count (struct bin_reader *o, size_t size)
+{
+	const size_t count = bin_get (o);
+
+	if (!o->ok || count > (size_t) (o->end - o->word) / size) {
+		o->ok = 0;
+		return 0;
+	}
+
+	return count;
+}
+
+/*
+ * Pairs and tuples of loaded model point into the mapped file, arrays of
+ * them are empty before and are allocated at once
+ */
+static void
+bin_get_pairs (struct bin_reader *o, struct pair **a, size_t *n, size_t *max)
+{
+	const size_t count = bin_get_count (o, 2);
+	struct pair *p;
+	size_t i;
+
+	if (count == 0)
+		return;
+
+	if ((p = array_alloc (p, count)) == NULL) {
+		o->ok = 0;
+		return;
+	}
+
+	for (i = 0; i < count; ++i) {
+		p[i].key   = (char *) bin_get_string (o, 1);
+		p[i].value = (char *) bin_get_string (o, 0);
+	}
+
+	*a = p;
+	*n = *max = count;
+}
+
+static void bin_get_tuple (struct bin_reader *o, struct tuple *t)
+{
+	const size_t size = bin_get_count (o, 1);
+	size_t i;
+
+	t->size = 0;
+	t->m    = NULL;
+
+	if (!o->ok || (t->m = array_alloc (t->m, size)) == NULL) {
+		o->ok = 0;
+		return;
+	}
+
+	for (i = 0; i < size; ++i)
+		t->m[i] = (char *) bin_get_string (o, 0);
+
+	t->size = size;
+}
+
+static void bin_get_cell (struct bin_reader *o, struct model *m)
+{
+	const char *type = bin_get_string (o, 0);
+	const char *name = bin_get_string (o, 0);
+	struct cell *c;
+	size_t count;
+
+	if (!o->ok || !model_add_cell (m, type, name)) {
+		o->ok = 0;
+		return;
+	}
+
+	c = seq_last (&m->cell);
+
+	bin_get_pairs (o, &c->bind,  &c->nbinds,  &c->maxbinds);
+	bin_get_pairs (o, &c->param, &c->nparams, &c->maxparams);
+	bin_get_pairs (o, &c->attr,  &c->nattrs,  &c->maxattrs);
+
+	if ((count = bin_get_count (o, 1)) == 0)
+		return;
+
+	if ((c->tuple = array_alloc (c->tuple, count)) == NULL) {
+		o->ok = 0;
+		return;
+	}
+
+	for (c->maxtuples = count; o->ok && c->ntuples < count; ++c->ntuples)
+		bin_get_tuple (o, c->tuple + c->ntuples);
+}
+
+static void bin_get_port (struct bin_reader *o, struct model *m)
+{
+	const char *name = bin_get_string (o, 0);
+	const int type = bin_get (o);
+	const uint32_t cell = bin_get (o);
+	const size_t ref = bin_get (o);
+
+	if (cell != BIN_NONE && cell >= m->cell.count)
+		o->ok = 0;
+
+	if (o->ok)
+		o->ok = model_add_port (m, name, type, cell == BIN_NONE ? NULL :
+					model_cell (m, cell), ref);
+}
+
+static void bin_get_model (struct bin_reader *o, struct model *m)
+{
+	size_t count, i;
+
+	m->last = m;  /* ports go to this model */
+
+	bin_get_pairs (o, &m->param, &m->nparams, &m->maxparams);
+
+	for (count = bin_get (o), i = 0; o->ok && i < count; ++i)
+		bin_get_cell (o, m);
+
+	for (count = bin_get (o), i = 0; o->ok && i < count; ++i)
+		bin_get_port (o, m);
+
+	for (count = bin_get (o), i = 0; o->ok && i < count; ++i)
+		if (!(o->ok = model_add_model (m, bin_get_string (o, 0))))
+			break;
+		else
+			bin_get_model (o, model_sub (m, i));
+}
+
+/*
+ * Every string of file is added to the table of model tree as is, thus
+ * cells of model take strings from the mapped file, not copies of them
+ */
+static int bin_borrow (struct bin_reader *o, struct intern_table *t)
+{
+	size_t i;
+
+	for (i = 0; i < o->nstrings; ++i)
+		if (o->offset[i] >= o->strsize)
+			o->ok = 0;
+		else if (intern_borrow (t, o->data + o->offset[i]) == NULL)
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Sizes are checked one by one as they are read from untrusted header,
+ * thus their sum cannot wrap
+ */
+static struct model *bin_load (const void *map, size_t size)
+{
+	const struct bin_head *h = map;
+	struct bin_reader r = { 0 };
+	struct model *o;
+	size_t offsets, rest;
+
+	if (size < sizeof (*h) || memcmp (h->magic, BIN_MAGIC, 8) != 0 ||
+	    h->version != BIN_VERSION || h->order != BIN_ORDER)
+		goto wrong;
+
+	offsets = sizeof (*h) + sizeof (r.offset[0]) * h->nstrings;
+
+	if (offsets > size || h->strsize > size - offsets ||
+	    h->strsize % 4 != 0)
+		goto wrong;
+
+	rest = size - offsets - h->strsize;
+
+	if (rest % 4 != 0 || h->nwords != rest / 4 ||
+	    (h->strsize > 0 &&
+	     ((const char *) map)[offsets + h->strsize - 1] != '\0'))
+		goto wrong;
+
+	r.offset   = (const void *) (h + 1);
+	r.nstrings = h->nstrings;
+	r.data     = (const char *) map + offsets;
+	r.strsize  = h->strsize;
+	r.word     = (const void *) (r.data + h->strsize);
+	r.end      = r.word + h->nwords;
+	r.ok       = 1;
+
+	if ((o = model_alloc (NULL, bin_get_string (&r, 0))) == NULL)
+		return NULL;
+
+	o->strings = o->names;
+
+	if (!bin_borrow (&r, o->strings)) {
+		model_free (o);
+		return NULL;
+	}
+
+	if (r.ok)
+		bin_get_model (&r, o);
+
+	if (r.ok && r.word == r.end) {
+		model_shrink (o);
+		return o;
+	}
+
+	model_free (o);
+wrong:
+	errno = EINVAL;
+	return NULL;
+}
+
+/*
+ * Mapping is kept by loaded model and is unmapped by model_free
+ */
+struct model *model_load_binary (const char *path)
+{
+	struct model *o;
+	struct stat st;
+	size_t size;
+	void *map;
+	int fd;
+
+	if ((fd = open (path, O_RDONLY)) < 0)
+		return NULL;
+
+	if (fstat (fd, &st) != 0)
+		goto no_map;
+
+	if (st.st_size == 0 || (uintmax_t) st.st_size >= SIZE_MAX) {
+		errno = EINVAL;
+		goto no_map;
+	}
+
+	size = st.st_size;
+	map  = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (map == MAP_FAILED)
+		goto no_map;
+
+	close (fd);
+
+	if ((o = bin_load (map, size)) == NULL) {
+		munmap (map, size);
+		return NULL;
+	}
+
+	o->image      = map;
+	o->image_size = size;
+	return o;
+no_map:
+	close (fd);
+	return NULL;
+}
@@ -9,21 +9,22 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/alloc.h>
 #include <dakota/data/array.h>
+#include <dakota/data/intern.h>
 #include <dakota/model/cell.h>
 
-int cell_init (struct cell *o, const char *type, const char *name)
+int cell_init (struct cell *o, struct intern_table *names,
+	       const char *type, const char *name)
 {
-	if ((o->type = strdup (type)) == NULL)
+	if ((o->type = intern_add (names, type)) == NULL ||
+	    (o->name = intern_add (names, name)) == NULL)
 		return 0;
 
-	if ((o->name = strdup (name)) == NULL)
-		goto no_name;
-
-	o->nbinds  = 0;
-	o->nparams = 0;
-	o->nattrs  = 0;
-	o->ntuples = 0;
+	o->nbinds  = o->maxbinds  = 0;
+	o->nparams = o->maxparams = 0;
+	o->nattrs  = o->maxattrs  = 0;
+	o->ntuples = o->maxtuples = 0;
 
 	o->bind    = NULL;
 	o->param   = NULL;
@@ -31,58 +32,95 @@ int cell_init (struct cell *o, const char *type, const char *name)
 	o->tuple   = NULL;
 
 	o->map = NULL;
+	o->lut = NULL;
+
+	o->strings = NULL;
 	return 1;
-no_name:
-	free (o->type);
-	return 0;
 }
 
+/*
+ * Strings of pairs and tuples are either owned by cell or are interned
+ * into the table of strings, then pairs need no finalization
+ */
 void cell_fini (struct cell *o)
 {
-	free (o->type);
-	free (o->name);
+	const int own = o->strings == NULL;
 
-	array_free (o->bind,  o->nbinds,  pair_fini);
-	array_free (o->param, o->nparams, pair_fini);
-	array_free (o->attr,  o->nattrs,  pair_fini);
-	array_free (o->tuple, o->ntuples, tuple_fini);
+	array_free (o->bind,  o->nbinds,  own ? pair_fini : NULL);
+	array_free (o->param, o->nparams, own ? pair_fini : NULL);
+	array_free (o->attr,  o->nattrs,  own ? pair_fini : NULL);
+	array_free (o->tuple, o->ntuples, own ? tuple_fini : tuple_intern_fini);
 
 	bitmap_free (o->map);
+	dakota_free (o->lut);
 }
 
-#define DEF_PAIR_ADD(attr, count)					\
+static void cell_drop_lut (struct cell *o)
+{
+	dakota_free (o->lut);
+	o->lut = NULL;
+}
+
+/*
+ * Drop unused capacity, best effort: arrays are kept as is on failure
+ */
+void cell_shrink (struct cell *o)
+{
+	void *p;
+
+	if ((p = array_shrink (o->bind, o->maxbinds, o->nbinds)) != NULL)
+		o->bind = p;
+
+	if ((p = array_shrink (o->param, o->maxparams, o->nparams)) != NULL)
+		o->param = p;
+
+	if ((p = array_shrink (o->attr, o->maxattrs, o->nattrs)) != NULL)
+		o->attr = p;
+
+	if ((p = array_shrink (o->tuple, o->maxtuples, o->ntuples)) != NULL)
+		o->tuple = p;
+}
+
+#define DEF_PAIR_ADD(attr, count, max)					\
 int cell_add_##attr (struct cell *o, const char *key, const char *value) \
 {									\
 	const size_t count = o->count + 1;				\
 	struct pair *p;							\
 									\
-	if ((p = array_resize (o->attr, count)) == NULL)		\
+	if ((p = array_grow (o->attr, o->max, count)) == NULL)		\
 		return 0;						\
 									\
+	cell_drop_lut (o);						\
+									\
 	o->attr = p;							\
 									\
-	if (!pair_init (o->attr + o->count, key, value))		\
+	if (o->strings != NULL ?					\
+	    !pair_intern (o->attr + o->count, o->strings, key, value) :	\
+	    !pair_init (o->attr + o->count, key, value))		\
 		return 0;						\
 									\
 	o->count = count;						\
 	return 1;							\
 }
 
-DEF_PAIR_ADD (bind,  nbinds)
-DEF_PAIR_ADD (param, nparams)
-DEF_PAIR_ADD (attr,  nattrs)
+DEF_PAIR_ADD (bind,  nbinds,  maxbinds)
+DEF_PAIR_ADD (param, nparams, maxparams)
+DEF_PAIR_ADD (attr,  nattrs,  maxattrs)
 
 int cell_add_tuple_va (struct cell *o, int size, va_list ap)
 {
 	const size_t ntuples = o->ntuples + 1;
 	struct tuple *p;
 
-	if ((p = array_resize (o->tuple, ntuples)) == NULL)
+	if ((p = array_grow (o->tuple, o->maxtuples, ntuples)) == NULL)
 		return 0;
 
 	o->tuple = p;
+	cell_drop_lut (o);
 
-	if (!tuple_init_va (o->tuple + o->ntuples, size, ap))
+	if (o->strings != NULL ?
+	    !tuple_intern_va (o->tuple + o->ntuples, o->strings, size, ap) :
+	    !tuple_init_va (o->tuple + o->ntuples, size, ap))
 		return 0;
 
 	o->ntuples = ntuples;
@@ -94,12 +132,15 @@ int cell_add_tuple_v (struct cell *o, int size, const char *argv[])
 	const size_t ntuples = o->ntuples + 1;
 	struct tuple *p;
 
-	if ((p = array_resize (o->tuple, ntuples)) == NULL)
+	if ((p = array_grow (o->tuple, o->maxtuples, ntuples)) == NULL)
 		return 0;
 
 	o->tuple = p;
+	cell_drop_lut (o);
 
-	if (!tuple_init_v (o->tuple + o->ntuples, size, argv))
+	if (o->strings != NULL ?
+	    !tuple_intern_v (o->tuple + o->ntuples, o->strings, size, argv) :
+	    !tuple_init_v (o->tuple + o->ntuples, size, argv))
 		return 0;
 
 	o->ntuples = ntuples;
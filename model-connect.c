@@ -6,10 +6,16 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include <dakota/alloc.h>
+#include <dakota/data/array.h>
+#include <dakota/data/intern.h>
 #include <dakota/string.h>
 
 #include "model-connect.h"
@@ -22,6 +28,7 @@ static int model_add_driven (struct model *o, const char *name,
 			     struct cell *cell, size_t ref)
 {
 	size_t port;
+	struct port *p;
 
 	if ((port = model_get_port (o, name)) != M_UNKNOWN)
 		goto exists;
@@ -33,15 +40,17 @@ static int model_add_driven (struct model *o, const char *name,
 
 	return 1;
 exists:
-	if ((o->port[port].type & PORT_DRIVEN) != 0)
+	p = model_port (o, port);
+
+	if ((p->type & PORT_DRIVEN) != 0)
 		return error (&o->error, "multiple drivers for %s", name);
 
 	if (cell != NULL) {
-		o->port[port].cell = cell;
-		o->port[port].ref  = ref;
+		p->cell = cell;
+		p->ref  = ref;
 	}
 
-	o->port[port].type |= PORT_DRIVEN;
+	p->type |= PORT_DRIVEN;
 	return 1;
 }
 
@@ -137,35 +146,45 @@ static int model_bind_latch (struct model *o, struct cell *c)
 	return ok;
 }
 
-static int model_bind_port (struct model *o, const char *name, const char *bind,
-			    struct model *type, struct cell *cell, size_t ref)
+/*
+ * Plan of cell of other model: cell entry then one entry per bind
+ */
+enum connect_plan {
+	PLAN_INPUT,		/* bind to input port of cell model	*/
+	PLAN_OUTPUT,		/* bind to output port of cell model	*/
+	PLAN_CELL,		/* cell model found			*/
+	PLAN_NO_MODEL,
+	PLAN_NO_PORT,
+	PLAN_MANY_ARGS,
+	PLAN_LOCAL_PORT,
+};
+
+static int model_bind_port (struct model *o, struct cell *cell, size_t ref,
+			    int plan)
 {
-	int ok;
-
-	if (ref >= type->nports)
+	const char *name = cell->bind[ref].key;
+	const char *bind = cell->bind[ref].value;
+
+	switch (plan) {
+	case PLAN_INPUT:
+		return model_add_local  (o, bind, cell, ref);
+	case PLAN_OUTPUT:
+		return model_add_driven (o, bind, cell, ref);
+	case PLAN_MANY_ARGS:
 		return model_error (o, "too many args for cell %s", cell->type);
-
-	if (name != NULL &&
-	    (ref = model_get_port (type, name)) == M_UNKNOWN)
+	case PLAN_NO_PORT:
 		return model_error (o, "cannot find port %s for cell %s",
 				    name, cell->type);
-
-	if ((type->port[ref].type & PORT_LOCAL) != 0)
+	default:
 		return model_error (o, "cannot bind %s to local port of "
 				    "cell %s", bind, cell->type);
-
-	ok = (type->port[ref].type & PORT_INPUT) != 0 ?
-	     model_add_local  (o, bind, cell, ref):
-	     model_add_driven (o, bind, cell, ref);
-
-	return ok;
+	}
 }
 
-static int model_bind_cell (struct model *o, struct cell *cell)
+static int model_bind_cell (struct model *o, struct cell *cell,
+			    const unsigned char **plan)
 {
-	struct model *type;
 	size_t ref;
-	const char *port, *value;
 
 	if (strcmp (cell->type, "table") == 0)
 		return model_bind_table (o, cell);
@@ -173,17 +192,13 @@ static int model_bind_cell (struct model *o, struct cell *cell)
 	if (strcmp (cell->type, "latch") == 0)
 		return model_bind_latch (o, cell);
 
-	if ((type = model_get_model (o, cell->type)) == NULL)
+	if (*(*plan)++ == PLAN_NO_MODEL)
 		return error (&o->error, "cannot find model %s for cell %s",
 			      cell->type, cell->name);
 
-	for (ref = 0; ref < cell->nbinds; ++ref) {
-		port  = cell->bind[ref].key;
-		value = cell->bind[ref].value;
-
-		if (!model_bind_port (o, port, value, type, cell, ref))
+	for (ref = 0; ref < cell->nbinds; ++ref)
+		if (!model_bind_port (o, cell, ref, *(*plan)++))
 			return 0;
-	}
 
 	return 1;
 }
@@ -196,7 +211,7 @@ static int model_port_is_driven (struct model *o, struct port *port)
 	return error (&o->error, "no driver for %s", port->name);
 }
 
-int model_connect (struct model *o)
+static int model_connect_one (struct model *o, const unsigned char *plan)
 {
 	size_t i;
 
@@ -204,19 +219,243 @@ int model_connect (struct model *o)
 		if (!model_bind_param (o, o->param + i))
 			return 0;
 
-	for (i = 0; i < o->ncells; ++i)
-		if (!model_bind_cell (o, o->cell + i))
+	for (i = 0; i < o->cell.count; ++i)
+		if (!model_bind_cell (o, model_cell (o, i), &plan))
 			return 0;
 
-	for (i = 0; i < o->nports; ++i)
-		if (!model_port_is_driven (o, o->port + i))
+	for (i = 0; i < o->port.count; ++i)
+		if (!model_port_is_driven (o, model_port (o, i)))
 			return 0;
 
-	for (i = 0; i < o->nmodels; ++i)
-		if (!model_connect (o->model + i)) {
-			error_move (&o->error, &o->model[i].error);
-			return 0;
+	return 1;
+}
+
+/*
+ * Connect runs in two phases. First, serially, models of cells are
+ * resolved and bound ports of them are looked up: this is the only
+ * phase that reads other models, and ports of a model are indexed on
+ * first lookup here. Then every model binds its cells to its own ports,
+ * models are independent at this phase and are connected by a pool of
+ * workers. The first error in tree order wins, as it does for serial
+ * connect of parent before its sub-models.
+ */
+struct connect_job {
+	struct model *model;
+	unsigned char *plan;
+	int ok;
+};
+
+struct connect {
+	size_t count, max, ncells;
+	struct connect_job *job;
+	atomic_size_t next;
+};
+
+static int connect_plan_port (struct model *type, const struct pair *bind,
+			      size_t ref)
+{
+	int dir;
+
+	if (ref >= type->port.count)
+		return PLAN_MANY_ARGS;
+
+	if (bind->key != NULL &&
+	    (ref = model_get_port (type, bind->key)) == M_UNKNOWN)
+		return PLAN_NO_PORT;
+
+	dir = model_port (type, ref)->type;
+
+	return	(dir & PORT_LOCAL) != 0 ? PLAN_LOCAL_PORT :
+		(dir & PORT_INPUT) != 0 ? PLAN_INPUT : PLAN_OUTPUT;
+}
+
+static unsigned char *connect_plan (struct model *o)
+{
+	struct cell *cell;
+	struct model *type;
+	unsigned char *plan;
+	size_t size, i, pos, ref;
+
+	for (i = 0, size = 0; i < o->cell.count; ++i)
+		size += model_cell (o, i)->nbinds + 1;
+
+	if ((plan = dakota_alloc (ALLOC_MODEL, size)) == NULL)
+		return NULL;
+
+	for (i = 0, pos = 0; i < o->cell.count; ++i) {
+		cell = model_cell (o, i);
+
+		if (strcmp (cell->type, "table") == 0 ||
+		    strcmp (cell->type, "latch") == 0)
+			continue;
+
+		if ((type = model_get_model (o, cell->type)) == NULL) {
+			plan[pos++] = PLAN_NO_MODEL;
+			continue;
+		}
+
+		plan[pos++] = PLAN_CELL;
+
+		for (ref = 0; ref < cell->nbinds; ++ref)
+			plan[pos++] = connect_plan_port (type, cell->bind + ref,
+							 ref);
+	}
+
+	return plan;
+}
+
+/*
+ * Workers add ports to models concurrently: names of them are interned
+ * beforehand, intern of known name does not modify table of model tree
+ */
+static int connect_intern (struct model *o)
+{
+	const struct pair *p;
+	const struct cell *cell;
+	size_t i, j;
+	char *name;
+	int ok = 1;
+
+	for (i = 0; i < o->nparams; ++i) {
+		p = o->param + i;
+
+		if (strlen (p->value) == 1) {
+			ok &= intern_add (o->names, p->key) != NULL;
+			continue;
 		}
 
+		for (j = 0; ok && p->value[j] != '\0'; ++j) {
+			if ((name = make_string ("%s[%zu]", p->key, j)) == NULL)
+				return 0;
+
+			ok &= intern_add (o->names, name) != NULL;
+			free (name);
+		}
+	}
+
+	for (i = 0; i < o->cell.count; ++i)
+		for (cell = model_cell (o, i), j = 0; j < cell->nbinds; ++j)
+			ok &= intern_add (o->names,
+					  cell->bind[j].value) != NULL;
+
+	return ok;
+}
+
+static int connect_add (struct connect *c, struct model *o)
+{
+	struct connect_job *job;
+	size_t i;
+
+	if ((job = array_grow (c->job, c->max, c->count + 1)) == NULL)
+		return 0;
+
+	c->job = job;
+	job += c->count;
+
+	if ((job->plan = connect_plan (o)) == NULL)
+		return 0;
+
+	job->model = o;
+	c->ncells += o->cell.count;
+	++c->count;
+
+	for (i = 0; i < o->model.count; ++i)
+		if (!connect_add (c, model_sub (o, i)))
+			return 0;
+
 	return 1;
 }
+
+static void *connect_worker (void *cookie)
+{
+	struct connect *c = cookie;
+	struct connect_job *job;
+	size_t i;
+
+	while ((i = atomic_fetch_add (&c->next, 1)) < c->count) {
+		job = c->job + i;
+		job->ok = model_connect_one (job->model, job->plan);
+	}
+
+	return NULL;
+}
+
+/*
+ * Workers are not worth to start for small trees
+ */
+#define CONNECT_GRAIN  4096
+
+static size_t connect_workers (const struct connect *c)
+{
+	const long ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+	size_t count = c->count;
+
+	if (ncpus > 0 && count > (size_t) ncpus)
+		count = ncpus;
+
+	if (count > c->ncells / CONNECT_GRAIN + 1)
+		count = c->ncells / CONNECT_GRAIN + 1;
+
+	return count;
+}
+
+static void connect_run (struct connect *c, size_t count)
+{
+	pthread_t *tid;
+	size_t i, n;
+
+	atomic_init (&c->next, 0);
+
+	if (count < 2 ||
+	    (tid = dakota_alloc (ALLOC_MODEL, sizeof (tid[0]) * count)) == NULL) {
+		connect_worker (c);
+		return;
+	}
+
+	for (n = 0; n < count - 1; ++n)
+		if (pthread_create (tid + n, NULL, connect_worker, c) != 0)
+			break;
+
+	connect_worker (c);
+
+	for (i = 0; i < n; ++i)
+		pthread_join (tid[i], NULL);
+
+	dakota_free (tid);
+}
+
+int model_connect (struct model *o)
+{
+	struct connect c = { 0 };
+	size_t count, i;
+	int ok = 1;
+
+	if (!connect_add (&c, o))
+		goto no_mem;
+
+	if ((count = connect_workers (&c)) > 1)
+		for (i = 0; i < c.count; ++i)
+			if (!connect_intern (c.job[i].model))
+				goto no_mem;
+
+	connect_run (&c, count);
+
+	for (i = 0; i < c.count; ++i)
+		if (!c.job[i].ok) {
+			if (c.job[i].model != o)
+				error_move (&o->error, &c.job[i].model->error);
+
+			ok = 0;
+			break;
+		}
+
+	goto out;
+no_mem:
+	ok = model_error (o, NULL);
+out:
+	for (i = 0; i < c.count; ++i)
+		dakota_free (c.job[i].plan);
+
+	dakota_free (c.job);
+	return ok;
+}
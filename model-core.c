@@ -9,8 +9,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
+#include <dakota/alloc.h>
 #include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+#include <dakota/data/intern.h>
+#include <dakota/data/seq.h>
 #include <dakota/model.h>
 
 #include "model-core.h"
@@ -18,58 +23,169 @@
 int model_init (struct model *o, struct model *parent, const char *name)
 {
 	o->parent = parent;
-
-	if ((o->name = strdup (name)) == NULL)
+	o->strings = parent != NULL ? parent->strings : NULL;
+	o->image = NULL;
+	o->image_size = 0;
+
+	if (parent != NULL)
+		o->names = parent->names;
+	else if ((o->names = dakota_alloc (ALLOC_MODEL,
+					   sizeof (*o->names))) == NULL)
 		return 0;
+	else
+		intern_init (o->names);
+
+	if ((o->name = intern_add (o->names, name)) == NULL)
+		goto no_name;
 
 	o->last = o;
 
-	o->nparams = 0;
+	o->nparams = o->maxparams = 0;
 	o->param   = NULL;
-	o->nports  = 0;
-	o->port    = NULL;
-	o->ncells  = 0;
-	o->cell    = NULL;
-	o->nmodels = 0;
-	o->model   = NULL;
+	seq_init (&o->port, sizeof (struct port));
+	o->nslots  = 0;
+	o->slot    = NULL;
+	seq_init (&o->cell,  sizeof (struct cell));
+	seq_init (&o->model, sizeof (struct model));
+
+	o->serial    = 0;
+	o->nrefs     = 0;
+	o->nrefslots = 0;
+	o->refserial = 0;
+	o->ref       = NULL;
 
 	error_init (&o->error);
 	return 1;
+no_name:
+	if (parent == NULL) {
+		intern_fini (o->names);
+		dakota_free (o->names);
+	}
+
+	return 0;
 }
 
 void model_fini (struct model *o)
 {
-	free (o->name);
-
-	array_free (o->port,  o->nports,  port_fini);
-	array_free (o->cell,  o->ncells,  cell_fini);
-	array_free (o->model, o->nmodels, model_fini);
+	array_free (o->param, o->nparams, o->strings == NULL ? pair_fini : NULL);
+	seq_fini (&o->port, port_fini);
+	dakota_free (o->slot);
+	seq_fini (&o->cell,  cell_fini);
+	seq_fini (&o->model, model_fini);
+	dakota_free (o->ref);
 
 	error_fini (&o->error);
+
+	if (o->parent == NULL) {
+		intern_fini (o->names);
+		dakota_free (o->names);
+	}
+
+	if (o->image != NULL)
+		munmap (o->image, o->image_size);
+}
+
+/*
+ * Drop unused capacity of params and of cell arrays in model tree, best
+ * effort. Ports, cells and sub-models are kept in sequences and never
+ * move, thus this is safe at any time.
+ */
+void model_shrink (struct model *o)
+{
+	size_t i;
+	void *p;
+
+	if ((p = array_shrink (o->param, o->maxparams, o->nparams)) != NULL)
+		o->param = p;
+
+	for (i = 0; i < o->cell.count; ++i)
+		cell_shrink (model_cell (o, i));
+
+	for (i = 0; i < o->model.count; ++i)
+		model_shrink (model_sub (o, i));
+}
+
+/*
+ * Port index: open addressing hash of interned port names with linear
+ * probing, kept at most half full. Index is dropped when it is full and
+ * rebuilt on the next lookup, thus insertion stays amortized O(1).
+ */
+static size_t port_slot (const struct model *o, const char *name)
+{
+	const size_t mask = o->nslots - 1;
+	size_t i, k;
+
+	for (
+		i = hash_pointer (name) & mask;
+		(k = o->slot[i]) != M_UNKNOWN && model_port (o, k)->name != name;
+		i = (i + 1) & mask
+	)
+		/* probe next */;
+
+	return i;
+}
+
+static void port_index (struct model *o, size_t port)
+{
+	const size_t i = port_slot (o, model_port (o, port)->name);
+
+	if (o->slot[i] == M_UNKNOWN)  /* first port of that name wins */
+		o->slot[i] = port;
+}
+
+static int port_reindex (struct model *o)
+{
+	size_t nslots, i;
+
+	for (nslots = 16; nslots < o->port.count * 4; nslots *= 2) {}
+
+	dakota_free (o->slot);
+
+	if ((o->slot = dakota_alloc (ALLOC_MODEL,
+				     sizeof (o->slot[0]) * nslots)) == NULL) {
+		o->nslots = 0;
+		return 0;
+	}
+
+	o->nslots = nslots;
+
+	for (i = 0; i < nslots; ++i)
+		o->slot[i] = M_UNKNOWN;
+
+	for (i = 0; i < o->port.count; ++i)
+		port_index (o, i);
+
+	return 1;
 }
 
 int model_add_port (struct model *o, const char *name, int type,
 		    struct cell *cell, size_t ref)
 {
 	struct model *m = o->last;
-	const size_t nports = m->nports + 1;
 	struct port *p;
 	char alias[22];
 
-	if ((p = array_resize (m->port, nports)) == NULL)
+	if ((p = seq_next (&m->port)) == NULL)
 		return error (&o->error, NULL);
 
-	m->port = p;
-
 	if (name == NULL) {
-		snprintf (alias, sizeof (alias), "P%zu", m->nports);
+		snprintf (alias, sizeof (alias), "P%zu", m->port.count);
 		name = alias;
 	}
 
-	if (!port_init (m->port + m->nports, name, type, cell, ref))
+	if (!port_init (p, o->names, name, type, cell, ref))
 		return error (&o->error, NULL);
 
-	m->nports = nports;
+	seq_commit (&m->port);
+
+	if (m->nslots >= m->port.count * 2)
+		port_index (m, m->port.count - 1);
+	else if (m->nslots > 0) {
+		dakota_free (m->slot);
+		m->nslots = 0;
+		m->slot   = NULL;
+	}
+
 	return 1;
 }
 
@@ -99,24 +215,23 @@ int model_add_wire (struct model *o, const char *sink, const char *source)
 int model_add_cell (struct model *o, const char *type, const char *name)
 {
 	struct model *m = o->last;
-	const size_t ncells = m->ncells + 1;
 	struct cell *p;
 	char alias[22];
 
-	if ((p = array_resize (m->cell, ncells)) == NULL)
+	if ((p = seq_next (&m->cell)) == NULL)
 		return error (&o->error, NULL);
 
-	m->cell = p;
-
 	if (name == NULL) {
-		snprintf (alias, sizeof (alias), "U%zu", m->ncells);
+		snprintf (alias, sizeof (alias), "U%zu", m->cell.count);
 		name = alias;
 	}
 
-	if (!cell_init (m->cell + m->ncells, type, name))
+	if (!cell_init (p, o->names, type, name))
 		return error (&o->error, NULL);
 
-	m->ncells = ncells;
+	p->strings = m->strings;
+
+	seq_commit (&m->cell);
 	return 1;
 }
 
@@ -125,10 +240,10 @@ int model_add_bind (struct model *o, const char *port, const char *value)
 	struct model *m = o->last;
 	int ok;
 
-	if (m->ncells == 0)
+	if (m->cell.count == 0)
 		return error (&o->error, "no cell to bind to");
 
-	ok = cell_add_bind (m->cell + m->ncells - 1, port, value);
+	ok = cell_add_bind (seq_last (&m->cell), port, value);
 
 	return ok ? 1 : error (&o->error, NULL);
 }
@@ -137,28 +252,33 @@ const char *model_get_cell (struct model *o)
 {
 	struct model *m = o->last;
 
-	if (m->ncells == 0)
+	if (m->cell.count == 0)
 		return NULL;
 
-	return m->cell[m->ncells - 1].name;
+	return model_cell (m, m->cell.count - 1)->name;
+}
+
+static struct model *model_root (struct model *o)
+{
+	for (; o->parent != NULL; o = o->parent) {}
+
+	return o;
 }
 
 int model_add_model (struct model *o, const char *name)
 {
-	const size_t nmodels = o->nmodels + 1;
 	struct model *p;
 
-	if ((p = array_resize (o->model, nmodels)) == NULL)
+	if ((p = seq_next (&o->model)) == NULL)
 		return error (&o->error, NULL);
 
-	o->model = p;
-
-	if (!model_init (o->model + o->nmodels, o, name))
+	if (!model_init (p, o, name))
 		return error (&o->error, NULL);
 
-	o->last = o->model + o->nmodels;
+	o->last = p;
 
-	o->nmodels = nmodels;
+	seq_commit (&o->model);
+	++model_root (o)->serial;  /* new name may shadow, drop indexes */
 	return 1;
 }
 
@@ -167,10 +287,10 @@ int model_add_tuple_va (struct model *o, int size, va_list ap)
 	struct model *m = o->last;
 	int ok;
 
-	if (m->ncells == 0)
+	if (m->cell.count == 0)
 		return error (&o->error, "no cell to add tuple");
 
-	ok = cell_add_tuple_va (m->cell + m->ncells - 1, size, ap);
+	ok = cell_add_tuple_va (seq_last (&m->cell), size, ap);
 
 	return ok ? 1 : error (&o->error, NULL);
 }
@@ -180,10 +300,10 @@ int model_add_tuple_v (struct model *o, int size, const char *argv[])
 	struct model *m = o->last;
 	int ok;
 
-	if (m->ncells == 0)
+	if (m->cell.count == 0)
 		return error (&o->error, "no cell to add tuple");
 
-	ok = cell_add_tuple_v (m->cell + m->ncells - 1, size, argv);
+	ok = cell_add_tuple_v (seq_last (&m->cell), size, argv);
 
 	return ok ? 1 : error (&o->error, NULL);
 }
@@ -206,19 +326,21 @@ int model_add_param (struct model *o, const char *name, const char *value)
 	const size_t nparams = m->nparams + 1;
 	struct pair *p;
 
-	if (m->ncells > 0) {
-		if (!cell_add_param (m->cell + m->ncells - 1, name, value))
+	if (m->cell.count > 0) {
+		if (!cell_add_param (seq_last (&m->cell), name, value))
 			goto error;
 
 		return 1;
 	}
 
-	if ((p = array_resize (m->param, nparams)) == NULL)
+	if ((p = array_grow (m->param, m->maxparams, nparams)) == NULL)
 		goto error;
 
 	m->param = p;
 
-	if (!pair_init (m->param + m->nparams, name, value))
+	if (m->strings != NULL ?
+	    !pair_intern (m->param + m->nparams, m->strings, name, value) :
+	    !pair_init (m->param + m->nparams, name, value))
 		goto error;
 
 	m->nparams = nparams;
@@ -232,39 +354,160 @@ int model_add_attr (struct model *o, const char *name, const char *value)
 	struct model *m = o->last;
 	int ok;
 
-	if (m->ncells == 0)
+	if (m->cell.count == 0)
 		return error (&o->error, "no cell to add attribute");
 
-	ok = cell_add_attr (m->cell + m->ncells - 1, name, value);
+	ok = cell_add_attr (seq_last (&m->cell), name, value);
 
 	return ok ? 1 : error (&o->error, NULL);
 }
 
+/*
+ * Names are interned into table of model tree, thus if name was never
+ * interned there is no such port, and interned names are compared by
+ * pointer
+ */
 size_t model_get_port (struct model *o, const char *name)
 {
 	size_t i;
 
-	/* ToDo: create hash table to map port name to port index */
+	if ((name = intern_find (o->names, name)) == NULL ||
+	    o->port.count == 0)
+		return M_UNKNOWN;
 
-	for (i = 0; i < o->nports; ++i)
-		if (strcmp (o->port[i].name, name) == 0)
-			return i;
+	if (o->nslots == 0 && !port_reindex (o)) {
+		for (i = 0; i < o->port.count; ++i)  /* no memory for index */
+			if (model_port (o, i)->name == name)
+				return i;
 
-	return M_UNKNOWN;
+		return M_UNKNOWN;
+	}
+
+	return o->slot[port_slot (o, name)];
 }
 
-struct model *model_get_model (struct model *o, const char *name)
+/*
+ * Model index: open addressing hash of interned model names with linear
+ * probing, kept at most half full. It maps names of models of this scope
+ * and caches names resolved in parent scopes. Any added model in the tree
+ * may shadow cached names, thus index is valid only while its serial
+ * matches the serial of the root.
+ */
+static struct model_ref *model_slot (const struct model *o, const char *name)
 {
+	const size_t mask = o->nrefslots - 1;
 	size_t i;
 
+	for (
+		i = hash_pointer (name) & mask;
+		o->ref[i].name != NULL && o->ref[i].name != name;
+		i = (i + 1) & mask
+	)
+		/* probe next */;
+
+	return o->ref + i;
+}
+
+static void model_index (struct model *o, const char *name, struct model *m)
+{
+	struct model_ref *r = model_slot (o, name);
+
+	if (r->name != NULL)  /* first model of that name wins */
+		return;
+
+	r->name  = name;
+	r->model = m;
+	++o->nrefs;
+}
+
+static int model_reindex (struct model *o, size_t count)
+{
+	struct model_ref *old = o->ref;
+	const size_t nold = o->nrefslots;
+	size_t nslots, i;
+	struct model *m;
+
+	for (nslots = 16; nslots < count * 4; nslots *= 2) {}
+
+	if ((o->ref = dakota_zalloc (ALLOC_MODEL,
+				     sizeof (o->ref[0]) * nslots)) == NULL) {
+		o->ref = old;
+		return 0;
+	}
+
+	o->nrefs     = 0;
+	o->nrefslots = nslots;
+
+	if (old != NULL && o->refserial == model_root (o)->serial) {
+		for (i = 0; i < nold; ++i)  /* grow: keep cached names */
+			if (old[i].name != NULL)
+				model_index (o, old[i].name, old[i].model);
+	}
+	else
+		for (i = 0; i < o->model.count; ++i) {
+			m = model_sub (o, i);
+			model_index (o, m->name, m);
+		}
+
+	o->refserial = model_root (o)->serial;
+	dakota_free (old);
+	return 1;
+}
+
+static struct model *model_find (struct model *o, const char *name)
+{
+	struct model *m;
+	size_t i;
+
+	for (i = 0; i < o->model.count; ++i)  /* no memory for index */
+		if ((m = model_sub (o, i))->name == name)
+			return m;
+
+	return NULL;
+}
+
+static struct model *model_resolve (struct model *o, const char *name)
+{
+	struct model_ref *r;
+	struct model *m;
+
 	if (o == NULL)
 		return NULL;
 
-	/* ToDo: create hash table to map model name to model index */
+	if (o->refserial != model_root (o)->serial || o->ref == NULL)
+		if (!model_reindex (o, o->model.count))
+			return	(m = model_find (o, name)) != NULL ? m :
+				model_resolve (o->parent, name);
+
+	if ((r = model_slot (o, name))->name != NULL)
+		return r->model;
+
+	if ((m = model_resolve (o->parent, name)) == NULL)
+		return NULL;
+
+	/* cache resolved name, growing index as required */
+	if ((o->nrefs + 1) * 2 <= o->nrefslots ||
+	    model_reindex (o, o->nrefs + 1))
+		model_index (o, name, m);
+
+	return m;
+}
+
+/*
+ * Names are interned into table of model tree, thus if name was never
+ * interned there is no such model, and interned names are compared by
+ * pointer. Models of scopes shadow the root, the root matches its own
+ * name last.
+ */
+struct model *model_get_model (struct model *o, const char *name)
+{
+	struct model *m;
+
+	if ((name = intern_find (o->names, name)) == NULL)
+		return NULL;
 
-	for (i = 0; i < o->nmodels; ++i)
-		if (strcmp (o->model[i].name, name) == 0)
-			return o->model + i;
+	if ((m = model_resolve (o, name)) != NULL)
+		return m;
 
-	return model_get_model (o->parent, name);
+	return (m = model_root (o))->name == name ? m : NULL;
 }
@@ -11,37 +11,67 @@
 
 #include <stddef.h>
 
+#include <dakota/data/intern.h>
 #include <dakota/data/pair.h>
+#include <dakota/data/seq.h>
 #include <dakota/error.h>
+#include <dakota/model.h>
 #include <dakota/model/cell.h>
 #include <dakota/model/port.h>
 
+struct model_ref {
+	const char *name;	/* interned, NULL for empty slot */
+	struct model *model;
+};
+
 struct model {
 	struct model *parent;
-	char *name;
+	struct intern_table *names;	/* of tree, owned by root */
+	struct intern_table *strings;	/* owner of strings, NULL if cells */
+	void  *image;			/* kept binary model, root only */
+	size_t image_size;
+	const char *name;	/* interned */
 	struct model *last;
 
-	size_t        nparams;
+	size_t        nparams, maxparams;
 	struct pair  *param;
-	size_t        nports;
-	struct port  *port;
-	size_t        ncells;
-	struct cell  *cell;
-	size_t        nmodels;
-	struct model *model;	/* referenced and/or secondary models */
+	struct seq    port;	/* of struct port, entries never move */
+	size_t        nslots;	/* port index size, power of two or zero */
+	size_t       *slot;	/* port index by name, M_UNKNOWN is empty */
+	struct seq    cell;	/* of struct cell, entries never move */
+	struct seq    model;	/* referenced and/or secondary models */
+
+	size_t        serial;	/* models added to this tree, root only */
+	size_t        nrefs, nrefslots, refserial;
+	struct model_ref *ref;	/* model index, with resolved parent names */
 
 	struct error  error;
 };
 
 int  model_init (struct model *o, struct model *parent, const char *name);
 void model_fini (struct model *o);
+void model_shrink (struct model *o);
 
 int model_add_port (struct model *o, const char *name, int type,
 		    struct cell *cell, size_t ref);
 
 #define M_UNKNOWN  ((size_t) -1)
 
+static inline struct port *model_port (const struct model *o, size_t i)
+{
+	return seq_at (&o->port, i);
+}
+
+static inline struct cell *model_cell (const struct model *o, size_t i)
+{
+	return seq_at (&o->cell, i);
+}
+
+static inline struct model *model_sub (const struct model *o, size_t i)
+{
+	return seq_at (&o->model, i);
+}
+
 size_t model_get_port (struct model *o, const char *name);
-struct model *model_get_model (struct model *o, const char *name);
 
 #endif  /* DAKOTA_MODEL_H */
@@ -0,0 +1,592 @@
+/*
+ * Dakota Model Flattening
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+#include <dakota/data/intern.h>
+#include <dakota/model.h>
+#include <dakota/string.h>
+
+#include "model-core.h"
+
+struct flat_param {
+	const char *name, *value;	/* name is stable */
+};
+
+struct flat_cell {
+	struct cell *cell;
+	const char *name;		/* stable */
+};
+
+/*
+ * Flattened body of a model: nets 0 .. nports - 1 are ports of the model
+ * in port order, nets of nested instances follow. Leaf cells are shared
+ * with source models, every cell takes one pin per bind: the net of bind
+ * or M_UNKNOWN for binds that are not nets ("->", latch type and init).
+ */
+struct flat {
+	struct model *model;
+	int busy;
+
+	size_t nnets, maxnets;
+	const char **net;		/* stable net names		*/
+	size_t nparams, maxparams;
+	struct flat_param *param;	/* params of nested models	*/
+	size_t ncells, maxcells;
+	struct flat_cell *cell;
+	size_t npins, maxpins;
+	size_t *pin;
+};
+
+/*
+ * Body cache: open addressing hash of model pointers with linear probing,
+ * kept at most half full. Every model is flattened once, instances only
+ * copy its body renaming nested nets and offsetting net ids. Names are
+ * either taken from source models or interned into names of the cache,
+ * thus they stay valid until the flat model is emitted.
+ */
+struct flat_cache {
+	struct model *top;		/* model to report errors to	*/
+	struct intern_table names;	/* generated X/name names	*/
+	size_t count, nslots;
+	struct flat **slot;
+};
+
+static void flat_free (struct flat *o)
+{
+	if (o == NULL)
+		return;
+
+	dakota_free (o->net);
+	dakota_free (o->param);
+	dakota_free (o->cell);
+	dakota_free (o->pin);
+	dakota_free (o);
+}
+
+static struct flat **flat_slot (struct flat_cache *c, struct model *m)
+{
+	const size_t mask = c->nslots - 1;
+	size_t i;
+
+	for (
+		i = hash_pointer (m) & mask;
+		c->slot[i] != NULL && c->slot[i]->model != m;
+		i = (i + 1) & mask
+	)
+		/* probe next */;
+
+	return c->slot + i;
+}
+
+static int flat_cache_grow (struct flat_cache *c)
+{
+	struct flat **old = c->slot;
+	const size_t nold = c->nslots;
+	size_t i;
+
+	c->nslots = nold == 0 ? 16 : nold * 2;
+
+	if ((c->slot = dakota_zalloc (ALLOC_MODEL,
+				      sizeof (c->slot[0]) * c->nslots)) == NULL) {
+		c->slot   = old;
+		c->nslots = nold;
+		return 0;
+	}
+
+	for (i = 0; i < nold; ++i)
+		if (old[i] != NULL)
+			*flat_slot (c, old[i]->model) = old[i];
+
+	dakota_free (old);
+	return 1;
+}
+
+static void flat_cache_fini (struct flat_cache *c)
+{
+	size_t i;
+
+	for (i = 0; i < c->nslots; ++i)
+		flat_free (c->slot[i]);
+
+	dakota_free (c->slot);
+	intern_fini (&c->names);
+}
+
+static const char *
+flat_name (struct flat_cache *c, const char *prefix, const char *name)
+{
+	char *s;
+	const char *p;
+
+	if ((s = make_string ("%s/%s", prefix, name)) == NULL)
+		return NULL;
+
+	p = intern_add (&c->names, s);
+	free (s);
+	return p;
+}
+
+/*
+ * Cell name given by user takes precedence over generated one
+ */
+static const char *flat_cell_name (const struct cell *o)
+{
+	const char *name = cell_get_attr (o, "cname");
+
+	return name != NULL ? name : o->name;
+}
+
+static int flat_add_net (struct flat *o, const char *name)
+{
+	const char **p;
+
+	if (name == NULL ||
+	    (p = array_grow (o->net, o->maxnets, o->nnets + 1)) == NULL)
+		return 0;
+
+	o->net = p;
+	o->net[o->nnets++] = name;
+	return 1;
+}
+
+static int flat_add_param (struct flat *o, const char *name, const char *value)
+{
+	struct flat_param *p;
+
+	if (name == NULL ||
+	    (p = array_grow (o->param, o->maxparams, o->nparams + 1)) == NULL)
+		return 0;
+
+	o->param = p;
+	o->param[o->nparams].name  = name;
+	o->param[o->nparams].value = value;
+	++o->nparams;
+	return 1;
+}
+
+static int flat_add_cell (struct flat *o, struct cell *cell, const char *name)
+{
+	struct flat_cell *p;
+
+	if (name == NULL ||
+	    (p = array_grow (o->cell, o->maxcells, o->ncells + 1)) == NULL)
+		return 0;
+
+	o->cell = p;
+	o->cell[o->ncells].cell = cell;
+	o->cell[o->ncells].name = name;
+	++o->ncells;
+	return 1;
+}
+
+static int flat_grow_pins (struct flat *o, size_t count)
+{
+	size_t *p;
+
+	if ((p = array_grow (o->pin, o->maxpins, o->npins + count)) == NULL)
+		return 0;
+
+	o->pin = p;
+	return 1;
+}
+
+static int flat_add_pin (struct flat_cache *c, struct flat *o, const char *net)
+{
+	size_t pin = M_UNKNOWN;
+
+	if (net != NULL &&
+	    (pin = model_get_port (o->model, net)) == M_UNKNOWN)
+		return model_error (c->top, "cannot find net %s in model %s",
+				    net, o->model->name);
+
+	o->pin[o->npins++] = pin;
+	return 1;
+}
+
+/*
+ * Binds of table are nets but "->", latch binds are input, output,
+ * optional type and control, and optional init value
+ */
+static int flat_add_leaf (struct flat_cache *c, struct flat *o,
+			  struct cell *cell)
+{
+	const int latch = strcmp (cell->type, "latch") == 0;
+	const char *net;
+	size_t i;
+	int ok = 1;
+
+	if (!flat_add_cell (o, cell, flat_cell_name (cell)) ||
+	    !flat_grow_pins (o, cell->nbinds))
+		return model_error (c->top, NULL);
+
+	for (i = 0; i < cell->nbinds; ++i) {
+		net = cell->bind[i].value;
+
+		if (latch ? i == 2 || i == 4 : strcmp (net, "->") == 0)
+			net = NULL;
+
+		ok &= flat_add_pin (c, o, net);
+	}
+
+	return ok;
+}
+
+static const struct pair *
+flat_find_param (const struct pair *param, size_t count, const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+		if (strcmp (param[i].key, name) == 0)
+			return param + i;
+
+	return NULL;
+}
+
+static size_t flat_get_bit (struct model *m, const char *name, size_t width,
+			    size_t i)
+{
+	char *s;
+	size_t port;
+
+	if (width == 1)
+		return model_get_port (m, name);
+
+	if ((s = make_string ("%s[%zu]", name, i)) == NULL)
+		return M_UNKNOWN;
+
+	port = model_get_port (m, s);
+	free (s);
+	return port;
+}
+
+/*
+ * Param of instance given by name of param of enclosing model is wired to
+ * that param, other param values are constants and go to flat body
+ */
+static int flat_map_param (struct flat_cache *c, struct flat *o,
+			   const struct cell *x, struct model *type,
+			   const struct pair *p, size_t *map)
+{
+	const char *prefix = flat_cell_name (x);
+	struct model *m = o->model;
+	const size_t width = strlen (p->value);
+	const struct pair *v, *q;
+	size_t i, from, to;
+
+	if ((v = flat_find_param (x->param, x->nparams, p->key)) == NULL)
+		v = p;
+
+	if (v == p ||
+	    (q = flat_find_param (m->param, m->nparams, v->value)) == NULL) {
+		if (strlen (v->value) != width)
+			goto width;
+
+		if (!flat_add_param (o, flat_name (c, prefix, p->key),
+				     v->value))
+			return model_error (c->top, NULL);
+
+		return 1;
+	}
+
+	if (strlen (q->value) != width)
+		goto width;
+
+	for (i = 0; i < width; ++i) {
+		from = flat_get_bit (type, p->key, width, i);
+		to   = flat_get_bit (m, q->key, width, i);
+
+		if (from == M_UNKNOWN || to == M_UNKNOWN)
+			return model_error (c->top, "cannot bind param %s of "
+					    "cell %s", p->key, prefix);
+
+		map[from] = to;
+	}
+
+	return 1;
+width:
+	return model_error (c->top, "wrong width of param %s for cell %s",
+			    p->key, prefix);
+}
+
+static int flat_map_ports (struct flat_cache *c, struct flat *o,
+			   const struct cell *x, struct model *type, size_t *map)
+{
+	const size_t nports = type->port.count;
+	size_t i, port, net;
+
+	for (i = 0; i < nports; ++i)
+		map[i] = M_UNKNOWN;
+
+	for (i = 0; i < x->nbinds; ++i) {
+		if (x->bind[i].key == NULL) {
+			if ((port = i) >= nports)
+				return model_error (c->top, "too many args for "
+						    "cell %s", x->type);
+		}
+		else if ((port = model_get_port (type, x->bind[i].key))
+			 == M_UNKNOWN ||
+			 (model_port (type, port)->type & PORT_LOCAL) != 0)
+			return model_error (c->top, "cannot find port %s for "
+					    "cell %s", x->bind[i].key, x->type);
+
+		if ((net = model_get_port (o->model, x->bind[i].value))
+		    == M_UNKNOWN)
+			return model_error (c->top, "cannot find net %s in "
+					    "model %s", x->bind[i].value,
+					    o->model->name);
+
+		map[port] = net;
+	}
+
+	for (i = 0; i < x->nparams; ++i)
+		if (flat_find_param (type->param, type->nparams,
+				     x->param[i].key) == NULL)
+			return model_error (c->top, "cannot find param %s for "
+					    "cell %s", x->param[i].key,
+					    x->type);
+
+	for (i = 0; i < type->nparams; ++i)
+		if (!flat_map_param (c, o, x, type, type->param + i, map))
+			return 0;
+
+	return 1;
+}
+
+/*
+ * Ports of instance model are mapped to nets of enclosing model, the rest
+ * of its nets are renamed and placed after the nets of enclosing body
+ */
+static int flat_add_body (struct flat_cache *c, struct flat *o,
+			  const struct cell *x, const struct flat *b)
+{
+	const size_t nports = b->model->port.count;
+	const char *prefix = flat_cell_name (x);
+	size_t *map, base, i, pin;
+	struct port *p;
+	int ok = 0;
+
+	if ((map = array_alloc (map, nports)) == NULL)
+		goto no_mem;
+
+	if (!flat_map_ports (c, o, x, b->model, map))
+		goto error;
+
+	for (i = 0; i < nports; ++i) {
+		if (map[i] != M_UNKNOWN)
+			continue;
+
+		if (((p = model_port (b->model, i))->type & PORT_INPUT) != 0) {
+			model_error (c->top, "input %s of cell %s is not bound",
+				     p->name, prefix);
+			goto error;
+		}
+
+		map[i] = o->nnets;
+
+		if (!flat_add_net (o, flat_name (c, prefix, p->name)))
+			goto no_mem;
+	}
+
+	for (base = o->nnets, i = nports; i < b->nnets; ++i)
+		if (!flat_add_net (o, flat_name (c, prefix, b->net[i])))
+			goto no_mem;
+
+	for (i = 0; i < b->nparams; ++i)
+		if (!flat_add_param (o, flat_name (c, prefix, b->param[i].name),
+				     b->param[i].value))
+			goto no_mem;
+
+	for (i = 0; i < b->ncells; ++i)
+		if (!flat_add_cell (o, b->cell[i].cell,
+				    flat_name (c, prefix, b->cell[i].name)))
+			goto no_mem;
+
+	if (!flat_grow_pins (o, b->npins))
+		goto no_mem;
+
+	for (i = 0; i < b->npins; ++i)
+		o->pin[o->npins++] = (pin = b->pin[i]) == M_UNKNOWN ? pin :
+				     pin < nports ? map[pin] :
+				     base + pin - nports;
+
+	ok = 1;
+	goto error;
+no_mem:
+	model_error (c->top, NULL);
+error:
+	dakota_free (map);
+	return ok;
+}
+
+static const struct flat *flat_get (struct flat_cache *c, struct model *m);
+
+static int flat_add_instance (struct flat_cache *c, struct flat *o,
+			      const struct cell *x)
+{
+	struct model *type;
+	const struct flat *b;
+
+	if ((type = model_get_model (o->model, x->type)) == NULL)
+		return model_error (c->top, "cannot find model %s for cell %s",
+				    x->type, flat_cell_name (x));
+
+	if ((b = flat_get (c, type)) == NULL)
+		return 0;
+
+	return flat_add_body (c, o, x, b);
+}
+
+static int flat_build (struct flat_cache *c, struct flat *o)
+{
+	struct model *m = o->model;
+	struct cell *cell;
+	size_t i;
+
+	for (i = 0; i < m->port.count; ++i)
+		if (!flat_add_net (o, model_port (m, i)->name))
+			return model_error (c->top, NULL);
+
+	for (i = 0; i < m->cell.count; ++i) {
+		cell = model_cell (m, i);
+
+		if (strcmp (cell->type, "table") == 0 ||
+		    strcmp (cell->type, "latch") == 0) {
+			if (!flat_add_leaf (c, o, cell))
+				return 0;
+		}
+		else if (!flat_add_instance (c, o, cell))
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Find cached body of model or flatten it, bodies being flattened are
+ * marked busy to catch recursive models
+ */
+static const struct flat *flat_get (struct flat_cache *c, struct model *m)
+{
+	struct flat *o;
+
+	if (c->nslots > 0 && (o = *flat_slot (c, m)) != NULL) {
+		if (o->busy)
+			return error_p (&c->top->error, "recursive model %s",
+					m->name);
+		return o;
+	}
+
+	if ((c->count + 1) * 2 > c->nslots && !flat_cache_grow (c))
+		goto no_mem;
+
+	if ((o = dakota_zalloc (ALLOC_MODEL, sizeof (*o))) == NULL)
+		goto no_mem;
+
+	o->model = m;
+	o->busy  = 1;
+
+	*flat_slot (c, m) = o;
+	++c->count;
+
+	if (!flat_build (c, o))
+		return NULL;
+
+	o->busy = 0;
+	return o;
+no_mem:
+	return error_p (&c->top->error, NULL);
+}
+
+static int flat_emit_cell (struct model *o, const struct flat *b,
+			   size_t i, const size_t *pin)
+{
+	const struct cell *cell = b->cell[i].cell;
+	size_t j;
+	int ok = 1;
+
+	ok &= model_add_cell (o, cell->type, b->cell[i].name);
+
+	for (j = 0; ok && j < cell->nbinds; ++j)
+		ok &= model_add_bind (o, cell->bind[j].key,
+				      pin[j] == M_UNKNOWN ?
+				      cell->bind[j].value : b->net[pin[j]]);
+
+	for (j = 0; ok && j < cell->nparams; ++j)
+		ok &= model_add_param (o, cell->param[j].key,
+				       cell->param[j].value);
+
+	for (j = 0; ok && j < cell->nattrs; ++j)
+		ok &= model_add_attr (o, cell->attr[j].key,
+				      strcmp (cell->attr[j].key, "cname") == 0 ?
+				      b->cell[i].name : cell->attr[j].value);
+
+	for (j = 0; ok && j < cell->ntuples; ++j)
+		ok &= model_add_tuple_v (o, cell->tuple[j].size,
+					 (const char **) cell->tuple[j].m);
+
+	return ok;
+}
+
+/*
+ * Model params go first: params added after a cell belong to that cell
+ */
+static struct model *flat_emit (const struct flat *b)
+{
+	struct model *m = b->model, *o;
+	struct port *p;
+	size_t i, pin;
+	int ok = 1;
+
+	if ((o = model_alloc (NULL, m->name)) == NULL)
+		return error_p (&m->error, NULL);
+
+	for (i = 0; ok && i < m->port.count; ++i)
+		if (((p = model_port (m, i))->type & PORT_LOCAL) == 0)
+			ok = (p->type & PORT_INPUT) != 0 ?
+			     model_add_input  (o, p->name) :
+			     model_add_output (o, p->name);
+
+	for (i = 0; ok && i < m->nparams; ++i)
+		ok = model_add_param (o, m->param[i].key, m->param[i].value);
+
+	for (i = 0; ok && i < b->nparams; ++i)
+		ok = model_add_param (o, b->param[i].name, b->param[i].value);
+
+	for (i = 0, pin = 0; ok && i < b->ncells; ++i) {
+		ok = flat_emit_cell (o, b, i, b->pin + pin);
+		pin += b->cell[i].cell->nbinds;
+	}
+
+	if (ok && model_commit (o))
+		return o;
+
+	error_move (&m->error, &o->error);
+	model_free (o);
+	return NULL;
+}
+
+struct model *model_flatten (struct model *o)
+{
+	struct flat_cache c = { o };
+	const struct flat *b;
+	struct model *flat = NULL;
+
+	intern_init (&c.names);
+
+	if ((b = flat_get (&c, o)) != NULL)
+		flat = flat_emit (b);
+
+	flat_cache_fini (&c);
+	return flat;
+}
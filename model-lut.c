@@ -0,0 +1,172 @@
+/*
+ * Dakota Model Cell Truth Tables
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/model/cell.h>
+
+/*
+ * Minterms where input k is one
+ */
+static const uint64_t lut_var[CELL_LUT_INPUTS] = {
+	0xaaaaaaaaaaaaaaaaULL,
+	0xccccccccccccccccULL,
+	0xf0f0f0f0f0f0f0f0ULL,
+	0xff00ff00ff00ff00ULL,
+	0xffff0000ffff0000ULL,
+	0xffffffff00000000ULL,
+};
+
+/*
+ * Inputs go before "->", or all binds but the last are inputs when there
+ * is no arrow, as connect sees them
+ */
+static size_t lut_get_inputs (const struct cell *o, size_t *ncols)
+{
+	size_t i;
+
+	for (i = 0; i < o->nbinds; ++i)
+		if (strcmp (o->bind[i].value, "->") == 0) {
+			*ncols = o->nbinds - 1;
+			return i;
+		}
+
+	*ncols = o->nbinds;
+	return o->nbinds - 1;
+}
+
+/*
+ * Tuples of a row are concatenated, thus both ".names" rows like "11 1"
+ * and ".table" rows with one column per tuple are accepted
+ */
+static int lut_get_row (const struct tuple *t, size_t ncols, char *row)
+{
+	size_t i, len, pos;
+
+	for (i = 0, pos = 0; i < t->size; ++i, pos += len) {
+		if ((len = strlen (t->m[i])) > ncols - pos)
+			return 0;
+
+		memcpy (row + pos, t->m[i], len);
+	}
+
+	if (pos != ncols)
+		return 0;
+
+	for (i = 0; i < ncols; ++i)
+		if (row[i] != '0' && row[i] != '1' && row[i] != '-')
+			return 0;
+
+	return 1;
+}
+
+static uint64_t lut_cube (const char *row, size_t ninputs, uint64_t full)
+{
+	uint64_t m = full;
+	size_t i;
+
+	for (i = 0; i < ninputs; ++i)
+		if (row[i] == '1')
+			m &= lut_var[i];
+		else if (row[i] == '0')
+			m &= ~lut_var[i];
+
+	return m;
+}
+
+/*
+ * Output is given by on-set, or by off-set if there are no ones in its
+ * column, or it is constant zero if both are empty
+ */
+static int lut_build (struct cell *o, uint64_t *lut, size_t ninputs,
+		      size_t ncols)
+{
+	const size_t nout = ncols - ninputs;
+	const uint64_t full = ninputs == CELL_LUT_INPUTS ? ~0ULL :
+			      (1ULL << (1 << ninputs)) - 1;
+	uint64_t *off, m;
+	char *row;
+	size_t i, j;
+	int ok = 1;
+
+	if ((off = dakota_zalloc (ALLOC_MODEL,
+				  sizeof (off[0]) * nout + ncols)) == NULL)
+		return 0;
+
+	row = (char *) (off + nout);
+	memset (lut, 0, sizeof (lut[0]) * nout);
+
+	for (i = 0; i < o->ntuples; ++i) {
+		if (!lut_get_row (o->tuple + i, ncols, row)) {
+			errno = EINVAL;
+			ok = 0;
+			break;
+		}
+
+		m = lut_cube (row, ninputs, full);
+
+		for (j = 0; j < nout; ++j)
+			if (row[ninputs + j] == '1')
+				lut[j] |= m;
+			else if (row[ninputs + j] == '0')
+				off[j] |= m;
+	}
+
+	for (j = 0; j < nout; ++j)
+		if (lut[j] == 0 && off[j] != 0)
+			lut[j] = ~off[j] & full;
+
+	dakota_free (off);
+	return ok;
+}
+
+static int lut_is_wire (const struct cell *o)
+{
+	const char *kind = cell_get_attr (o, "cell-kind");
+
+	return o->ntuples == 0 && o->nbinds == 2 &&
+	       kind != NULL && strcmp (kind, "conn") == 0;
+}
+
+const uint64_t *cell_get_lut (struct cell *o)
+{
+	size_t ninputs, ncols;
+	uint64_t *lut;
+
+	if (o->lut != NULL)
+		return o->lut;
+
+	if (strcmp (o->type, "table") != 0 || o->nbinds == 0)
+		goto wrong;
+
+	if ((ninputs = lut_get_inputs (o, &ncols)) > CELL_LUT_INPUTS) {
+		errno = ERANGE;
+		return NULL;
+	}
+
+	if (ncols == ninputs)
+		goto wrong;
+
+	if ((lut = dakota_alloc (ALLOC_MODEL,
+				 sizeof (lut[0]) * (ncols - ninputs))) == NULL)
+		return NULL;
+
+	if (lut_is_wire (o))
+		lut[0] = lut_var[0] & 3;
+	else if (!lut_build (o, lut, ninputs, ncols)) {
+		dakota_free (lut);
+		return NULL;
+	}
+
+	return o->lut = lut;
+wrong:
+	errno = EINVAL;
+	return NULL;
+}
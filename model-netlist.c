@@ -0,0 +1,270 @@
+/*
+ * Dakota Compiled Netlist
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/array.h>
+#include <dakota/model.h>
+#include <dakota/model/netlist.h>
+
+#include "model-core.h"
+
+void netlist_free (struct netlist *o)
+{
+	if (o == NULL)
+		return;
+
+	dakota_free (o->net_name);
+	dakota_free (o->net_type);
+	dakota_free (o->net_driver);
+	dakota_free (o->net_load);
+	dakota_free (o->load);
+
+	dakota_free (o->cell);
+	dakota_free (o->cell_model);
+	dakota_free (o->cell_kind);
+	dakota_free (o->cell_pin);
+
+	dakota_free (o->pin_net);
+	dakota_free (o->pin_cell);
+	dakota_free (o->pin_port);
+	dakota_free (o->pin_dir);
+
+	dakota_free (o);
+}
+
+static int netlist_add_pin (struct netlist *o, size_t cell, const char *name,
+			    size_t port, int dir)
+{
+	const size_t net = model_get_port (o->model, name);
+	const size_t pin = o->npins;
+
+	if (net == M_UNKNOWN)
+		return model_error (o->model, "cannot find net %s for cell %s",
+				    name, o->cell[cell]->name);
+
+	if (dir == NL_OUT)
+		o->net_driver[net] = pin;
+
+	o->pin_net [pin] = net;
+	o->pin_cell[pin] = cell;
+	o->pin_port[pin] = port;
+	o->pin_dir [pin] = dir;
+
+	++o->npins;
+	return 1;
+}
+
+/*
+ * Classify binds as connect does: inputs go before "->" or all binds but
+ * the last are inputs when there is no arrow
+ */
+static int netlist_add_table (struct netlist *o, size_t cell)
+{
+	const struct cell *c = o->cell[cell];
+	size_t ref, col, ninputs;
+	const char *name;
+	int ok;
+
+	o->cell_kind[cell] = NL_TABLE;
+
+	for (
+		ref = col = 0, ninputs = c->nbinds - 1;
+		ref < c->nbinds;
+		++ref
+	) {
+		name = c->bind[ref].value;
+
+		if (strcmp (name, "->") == 0) {
+			ninputs = ref;
+			continue;
+		}
+
+		ok = netlist_add_pin (o, cell, name, col++,
+				      ref < ninputs ? NL_IN : NL_OUT);
+		if (!ok)
+			return 0;
+	}
+
+	return 1;
+}
+
+static int netlist_add_latch (struct netlist *o, size_t cell)
+{
+	const struct cell *c = o->cell[cell];
+	int ok = 1;
+
+	o->cell_kind[cell] = NL_LATCH;
+
+	if (c->nbinds < 2 || c->nbinds > 5)
+		return model_error (o->model, "wrong number of arguments for "
+				    "latch");
+
+	ok &= netlist_add_pin (o, cell, c->bind[0].value, NL_LATCH_D, NL_IN);
+	ok &= netlist_add_pin (o, cell, c->bind[1].value, NL_LATCH_Q, NL_OUT);
+
+	if (c->nbinds >= 4)
+		ok &= netlist_add_pin (o, cell, c->bind[3].value, NL_LATCH_C,
+				       NL_IN);
+
+	return ok;
+}
+
+static int netlist_add_subckt (struct netlist *o, size_t cell)
+{
+	const struct cell *c = o->cell[cell];
+	struct model *type;
+	size_t ref, port;
+	int dir;
+
+	o->cell_kind[cell] = NL_SUBCKT;
+
+	if ((type = model_get_model (o->model, c->type)) == NULL)
+		return model_error (o->model, "cannot find model %s for cell "
+				    "%s", c->type, c->name);
+
+	o->cell_model[cell] = type;
+
+	for (ref = 0; ref < c->nbinds; ++ref) {
+		port = c->bind[ref].key == NULL ? ref :
+		       model_get_port (type, c->bind[ref].key);
+
+		if (port >= type->port.count)
+			return model_error (o->model, "cannot find port %s "
+					    "for cell %s", c->bind[ref].key,
+					    c->type);
+
+		dir = (model_port (type, port)->type & PORT_INPUT) != 0 ?
+		      NL_IN : NL_OUT;
+
+		if (!netlist_add_pin (o, cell, c->bind[ref].value, port, dir))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int netlist_add_cell (struct netlist *o, size_t cell)
+{
+	const char *type = o->cell[cell]->type;
+
+	o->cell_pin[cell] = o->npins;
+
+	if (strcmp (type, "table") == 0)
+		return netlist_add_table (o, cell);
+
+	if (strcmp (type, "latch") == 0)
+		return netlist_add_latch (o, cell);
+
+	return netlist_add_subckt (o, cell);
+}
+
+/*
+ * Count loads of every net at net_load[n + 1], turn counts into offsets,
+ * then fill loads advancing net_load[n] to the end of net n and shift
+ * offsets back into place
+ */
+static void netlist_add_loads (struct netlist *o)
+{
+	size_t i, net;
+
+	for (i = 0; i <= o->nnets; ++i)
+		o->net_load[i] = 0;
+
+	for (i = 0; i < o->npins; ++i)
+		if (o->pin_dir[i] == NL_IN)
+			++o->net_load[o->pin_net[i] + 1];
+
+	for (i = 0; i < o->nnets; ++i)
+		o->net_load[i + 1] += o->net_load[i];
+
+	for (i = 0; i < o->npins; ++i)
+		if (o->pin_dir[i] == NL_IN) {
+			net = o->pin_net[i];
+			o->load[o->net_load[net]++] = i;
+		}
+
+	for (i = o->nnets; i > 0; --i)
+		o->net_load[i] = o->net_load[i - 1];
+
+	o->net_load[0] = 0;
+}
+
+struct netlist *netlist_alloc (struct model *m)
+{
+	struct netlist *o;
+	struct port *p;
+	size_t i, nbinds;
+
+	if ((o = dakota_zalloc (ALLOC_MODEL, sizeof (*o))) == NULL)
+		goto no_mem;
+
+	o->model  = m;
+	o->nnets  = m->port.count;
+	o->ncells = m->cell.count;
+
+	for (i = 0, nbinds = 0; i < o->ncells; ++i)
+		nbinds += model_cell (m, i)->nbinds;
+
+	o->net_name   = array_alloc (o->net_name,   o->nnets);
+	o->net_type   = array_alloc (o->net_type,   o->nnets);
+	o->net_driver = array_alloc (o->net_driver, o->nnets);
+	o->net_load   = array_alloc (o->net_load,   o->nnets + 1);
+	o->load       = array_alloc (o->load,       nbinds);
+
+	o->cell       = array_alloc (o->cell,       o->ncells);
+	o->cell_model = array_alloc (o->cell_model, o->ncells);
+	o->cell_kind  = array_alloc (o->cell_kind,  o->ncells);
+	o->cell_pin   = array_alloc (o->cell_pin,   o->ncells + 1);
+
+	o->pin_net    = array_alloc (o->pin_net,    nbinds);
+	o->pin_cell   = array_alloc (o->pin_cell,   nbinds);
+	o->pin_port   = array_alloc (o->pin_port,   nbinds);
+	o->pin_dir    = array_alloc (o->pin_dir,    nbinds);
+
+	if (o->net_name == NULL || o->net_type == NULL ||
+	    o->net_driver == NULL || o->net_load == NULL || o->load == NULL ||
+	    o->cell == NULL || o->cell_model == NULL || o->cell_kind == NULL ||
+	    o->cell_pin == NULL || o->pin_net == NULL || o->pin_cell == NULL ||
+	    o->pin_port == NULL || o->pin_dir == NULL)
+		goto no_mem;
+
+	for (i = 0; i < o->nnets; ++i) {
+		p = model_port (m, i);
+
+		o->net_name[i]   = p->name;
+		o->net_type[i]   = p->type;
+		o->net_driver[i] = NL_NONE;
+	}
+
+	for (i = 0; i < o->ncells; ++i) {
+		o->cell[i]       = model_cell (m, i);
+		o->cell_model[i] = NULL;
+
+		if (!netlist_add_cell (o, i))
+			goto error;
+	}
+
+	o->cell_pin[o->ncells] = o->npins;
+
+	netlist_add_loads (o);
+	return o;
+no_mem:
+	error (&m->error, NULL);
+error:
+	netlist_free (o);
+	return NULL;
+}
+
+size_t netlist_get_net (struct netlist *o, const char *name)
+{
+	const size_t net = model_get_port (o->model, name);
+
+	return net == M_UNKNOWN ? NL_NONE : net;
+}
@@ -6,15 +6,13 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
-#include <stdlib.h>
-#include <string.h>
-
+#include <dakota/data/intern.h>
 #include <dakota/model/port.h>
 
-int port_init (struct port *o, const char *name, int type,
-	       struct cell *cell, size_t ref)
+int port_init (struct port *o, struct intern_table *names, const char *name,
+	       int type, struct cell *cell, size_t ref)
 {
-	if ((o->name = strdup (name)) == NULL)
+	if ((o->name = intern_add (names, name)) == NULL)
 		return 0;
 
 	o->type = type;
@@ -25,5 +23,4 @@ int port_init (struct port *o, const char *name, int type,
 
 void port_fini (struct port *o)
 {
-	free (o->name);
 }
@@ -6,193 +6,175 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <dakota/model.h>
+#include <dakota/model/reader.h>
 #include <dakota/shell.h>
 
-static int on_model (struct model *o, const struct shell_cmd *cmd)
+int model_reader_error (struct model_reader *o, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf (o->error, sizeof (o->error), fmt, ap);
+	va_end(ap);
+
+	return 0;
+}
+
+#define CALL(name, ...)  \
+	(o->action->name == NULL || o->action->name (o->cookie, __VA_ARGS__))
+
+static int read_model (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	if (cmd->argc < 2)
-		return model_error (o, "no model name given");
+		return model_reader_error (o, "no model name given");
 
-	return model_add_model (o, cmd->argv[1]);
+	return CALL (on_model, cmd->argv[1]);
 }
 
-static int on_inputs (struct model *o, const struct shell_cmd *cmd)
+static int read_inputs (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	size_t i;
 
 	for (i = 1; i < cmd->argc; ++i)
-		if (!model_add_input (o, cmd->argv[i]))
+		if (!CALL (on_input, cmd->argv[i]))
 			return 0;
 
 	return 1;
 }
 
-static int on_outputs (struct model *o, const struct shell_cmd *cmd)
+static int read_outputs (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	size_t i;
 
 	for (i = 1; i < cmd->argc; ++i)
-		if (!model_add_output (o, cmd->argv[i]))
+		if (!CALL (on_output, cmd->argv[i]))
 			return 0;
 
 	return 1;
 }
 
-static int add_bind (struct model *o, char *expr)
+static int read_bind (struct model_reader *o, char *expr)
 {
 	char *p;
 
 	if ((p = strchr (expr, '=')) == NULL)
-		return model_add_bind (o, NULL, expr);
+		return CALL (on_bind, NULL, expr);
 
 	*p++ = '\0';
 
-	return model_add_bind (o, expr, p);
+	return CALL (on_bind, expr, p);
 }
 
-static int on_cell (struct model *o, const struct shell_cmd *cmd)
+static int read_binds (struct model_reader *o, const struct shell_cmd *cmd,
+		       size_t i)
 {
-	size_t i;
-
-	if (cmd->argc < 2)
-		return model_error (o, "no cell type given");
-
-	if (!model_add_cell (o, cmd->argv[1], NULL))
-		return 0;
-
-	if (!model_add_attr (o, "cell-kind", cmd->argv[0] + 1))
-		return 0;
-
-	for (i = 2; i < cmd->argc; ++i)
-		if (!add_bind (o, cmd->argv[i]))
+	for (; i < cmd->argc; ++i)
+		if (!read_bind (o, cmd->argv[i]))
 			return 0;
 
 	return 1;
 }
 
-static int on_table (struct model *o, const struct shell_cmd *cmd)
+static int read_cell (struct model_reader *o, const struct shell_cmd *cmd)
 {
-	size_t i;
-	int ok = 1;
-
 	if (cmd->argc < 2)
-		return model_error (o, "empty table");
+		return model_reader_error (o, "no cell type given");
 
-	ok &= model_add_cell (o, "table", NULL);
-	ok &= model_add_attr (o, "cell-kind", cmd->argv[0] + 1);
+	return CALL (on_cell, cmd->argv[0] + 1, cmd->argv[1]) &&
+	       read_binds (o, cmd, 2);
+}
 
-	for (i = 1; i < cmd->argc; ++i)
-		ok &= add_bind (o, cmd->argv[i]);
+static int read_table (struct model_reader *o, const struct shell_cmd *cmd)
+{
+	if (cmd->argc < 2)
+		return model_reader_error (o, "empty table");
 
-	return ok;
+	return CALL (on_cell, cmd->argv[0] + 1, "table") &&
+	       read_binds (o, cmd, 1);
 }
 
-static int on_wire (struct model *o, const struct shell_cmd *cmd)
+static int read_wire (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	if (cmd->argc < 3)
-		return model_error (o, "no wire input and output given");
+		return model_reader_error (o, "no wire input and output given");
 
-	return on_table (o, cmd);
+	return read_table (o, cmd);
 }
 
-static int on_latch (struct model *o, const struct shell_cmd *cmd)
+static int read_latch (struct model_reader *o, const struct shell_cmd *cmd)
 {
-	size_t i;
-	int ok = 1;
-
 	if (cmd->argc < 3)
-		return model_error (o, "no latch input and output given");
-
-	ok &= model_add_cell (o, "latch", NULL);
-	ok &= model_add_attr (o, "cell-kind", "latch");
-
-	for (i = 1; i < cmd->argc; ++i)
-		ok &= add_bind (o, cmd->argv[i]);
+		return model_reader_error (o, "no latch input and output given");
 
-	return ok;
+	return CALL (on_cell, "latch", "latch") && read_binds (o, cmd, 1);
 }
 
-static int on_tuple (struct model *o, const struct shell_cmd *cmd)
+static int read_tuple (struct model_reader *o, const struct shell_cmd *cmd)
 {
-	return model_add_tuple_v (o, cmd->argc, (const char **) cmd->argv);
+	return CALL (on_tuple, cmd->argc, (const char **) cmd->argv);
 }
 
-static int on_cname (struct model *o, const struct shell_cmd *cmd)
+static int read_cname (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	if (cmd->argc < 2)
-		return model_error (o, "no common name given");
+		return model_reader_error (o, "no common name given");
 
-	return model_add_attr (o, "cname", cmd->argv[1]);
+	return CALL (on_cname, cmd->argv[1]);
 }
 
-static int on_param (struct model *o, const struct shell_cmd *cmd)
+static int read_param (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	const char *value;
 
 	if (cmd->argc < 2)
-		return model_error (o, "no parameter name given");
+		return model_reader_error (o, "no parameter name given");
 
 	value = cmd->argc < 3 ? NULL : cmd->argv[2];
 
-	return model_add_param (o, cmd->argv[1], value);
+	return CALL (on_param, cmd->argv[1], value);
 }
 
-static int on_attr (struct model *o, const struct shell_cmd *cmd)
+static int read_attr (struct model_reader *o, const struct shell_cmd *cmd)
 {
 	const char *value;
 
 	if (cmd->argc < 2)
-		return model_error (o, "no attribute name given");
+		return model_reader_error (o, "no attribute name given");
 
 	value = cmd->argc < 3 ? NULL : cmd->argv[2];
 
-	return model_add_attr (o, cmd->argv[1], value);
+	return CALL (on_attr, cmd->argv[1], value);
 }
 
-static struct model *on_model_root (const struct shell_cmd *cmd)
+int model_parse (struct model_reader *o, const char *path)
 {
-	const char *name = (cmd->argc < 2) ? "empty" : cmd->argv[1];
-	struct model *o;
-
-	if ((o = model_alloc (NULL, name)) == NULL)
-		return NULL;
-
-	if (cmd->argc < 2)
-		model_error (o, "no model name given");
-
-	return o;
-}
-
-struct model *model_read (const char *path)
-{
-	struct model *o = NULL;
 	struct shell *sh;
 	const struct shell_cmd *cmd;
-	int ok;
-	char *e;
+	int ok = 1, found = 0;
+
+	o->lineno   = 0;
+	o->error[0] = '\0';
 
 	if ((sh = shell_alloc ("model", path)) == NULL)
-		return NULL;
+		return 0;
 
-	while ((cmd = shell_next (sh)) != NULL) {
-		if (o == NULL) {
-			if (strcmp (cmd->argv[0], ".model") != 0)
-				continue;  /* ignore all until model is given */
+	while (ok && (cmd = shell_next (sh)) != NULL) {
+		o->lineno = cmd->lineno;
 
-			if ((o = on_model_root (cmd)) == NULL ||
-			    model_status (o) != NULL)
-				break;
+		if (!found && strcmp (cmd->argv[0], ".model") != 0)
+			continue;  /* ignore all until model is given */
 
-			continue;
-		}
+		found = 1;
 
 #define PROC(name, func) \
-	strcmp (cmd->argv[0], "." #name)  == 0 ? on_ ## func (o, cmd)
+	strcmp (cmd->argv[0], "." #name)  == 0 ? read_ ## func (o, cmd)
 
 		ok = PROC (inputs,  inputs)  :
 		     PROC (outputs, outputs) :
@@ -206,20 +188,126 @@ struct model *model_read (const char *path)
 		     PROC (cname,   cname)   :
 		     PROC (param,   param)   :
 		     PROC (attr,    attr)    :
-		     cmd->argv[0][0] != '.' ? on_tuple (o, cmd) : 1;
-
-		if (!ok)
-			break;
+		     cmd->argv[0][0] != '.' ? read_tuple (o, cmd) : 1;
 	}
 
-	if (model_status (o) == NULL)
+	shell_free (sh);
+
+	if (ok && !found)
+		return model_reader_error (o, "no model given");
+
+	return ok;
+}
+
+/*
+ * Model builder: cookie points to root model, the first model read is
+ * the root and others are its sub-models
+ */
+static int on_model (void *cookie, const char *name)
+{
+	struct model **o = cookie;
+
+	if (*o == NULL)
+		return (*o = model_alloc (NULL, name)) != NULL;
+
+	return model_add_model (*o, name);
+}
+
+static int on_input (void *cookie, const char *name)
+{
+	struct model **o = cookie;
+
+	return model_add_input (*o, name);
+}
+
+static int on_output (void *cookie, const char *name)
+{
+	struct model **o = cookie;
+
+	return model_add_output (*o, name);
+}
+
+static int on_cell (void *cookie, const char *kind, const char *type)
+{
+	struct model **o = cookie;
+
+	return model_add_cell (*o, type, NULL) &&
+	       model_add_attr (*o, "cell-kind", kind);
+}
+
+static int on_bind (void *cookie, const char *port, const char *value)
+{
+	struct model **o = cookie;
+
+	return model_add_bind (*o, port, value);
+}
+
+static int on_tuple (void *cookie, size_t argc, const char **argv)
+{
+	struct model **o = cookie;
+
+	return model_add_tuple_v (*o, argc, argv);
+}
+
+static int on_cname (void *cookie, const char *name)
+{
+	struct model **o = cookie;
+
+	return model_add_attr (*o, "cname", name);
+}
+
+static int on_param (void *cookie, const char *name, const char *value)
+{
+	struct model **o = cookie;
+
+	return model_add_param (*o, name, value);
+}
+
+static int on_attr (void *cookie, const char *name, const char *value)
+{
+	struct model **o = cookie;
+
+	return model_add_attr (*o, name, value);
+}
+
+static const struct model_action action = {
+	.on_model	= on_model,
+	.on_input	= on_input,
+	.on_output	= on_output,
+
+	.on_cell	= on_cell,
+	.on_bind	= on_bind,
+	.on_tuple	= on_tuple,
+
+	.on_cname	= on_cname,
+	.on_param	= on_param,
+	.on_attr	= on_attr,
+};
+
+struct model *model_read (const char *path)
+{
+	struct model *o = NULL;
+	struct model_reader r = { &action, &o };
+	char *e;
+
+	if (model_parse (&r, path)) {
 		model_commit (o);
+		return o;
+	}
+
+	if (o == NULL && r.error[0] == '\0')
+		return NULL;
+
+	if (o == NULL && (o = model_alloc (NULL, "empty")) == NULL)
+		return NULL;
+
+	if (r.error[0] != '\0')
+		model_error (o, "%zu: %s", r.lineno, r.error);
 	else
-	if (cmd != NULL && (e = strdup (model_status (o))) != NULL) {
-		model_error (o, "%zu: %s", cmd->lineno, e);
+	if ((e = strdup (model_status (o))) != NULL) {
+		model_error (o, "%zu: %s", r.lineno, e);
 		free (e);
 	}
 
-	shell_free (sh);
 	return o;
 }
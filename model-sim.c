@@ -0,0 +1,497 @@
+/*
+ * Dakota Bit-Parallel Model Simulator
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/alloc.h>
+#include <dakota/data/array.h>
+#include <dakota/model/sim.h>
+#include <dakota/string.h>
+
+#include "model-core.h"
+
+/*
+ * Code is a sequence of table outputs in level order, every one is either
+ *
+ *	SIM_SOP, net, invert, ncubes, { nlits, lit ... } ...
+ *
+ * where literal is net * 2 + negate; output is OR of cubes, inverted for
+ * tables given by their off-set, and every cube is AND of its literals;
+ * or it is
+ *
+ *	SIM_LUT, net, ninputs, mask, input ...
+ *
+ * for tables with few inputs and many rows, where output is looked up in
+ * truth table of cell by a tree of multiplexers.
+ */
+enum sim_op {
+	SIM_SOP,
+	SIM_LUT,
+};
+
+struct sim {
+	struct netlist *nl;
+	uint64_t *value;		/* per net, one vector per bit	*/
+
+	size_t ncode, maxcode;
+	uint64_t *code;
+
+	size_t nlatches;
+	size_t *latch;			/* latch cells			*/
+	uint64_t *next;			/* latched data			*/
+};
+
+void sim_free (struct sim *o)
+{
+	if (o == NULL)
+		return;
+
+	dakota_free (o->value);
+	dakota_free (o->code);
+	dakota_free (o->latch);
+	dakota_free (o->next);
+	dakota_free (o);
+}
+
+static int sim_emit (struct sim *o, uint64_t x)
+{
+	uint64_t *p;
+
+	if ((p = array_grow (o->code, o->maxcode, o->ncode + 1)) == NULL)
+		return 0;
+
+	o->code = p;
+	o->code[o->ncode++] = x;
+	return 1;
+}
+
+/*
+ * Tuples of a row are concatenated, thus both ".names a b c" rows like
+ * "11 1" and ".table" rows with one column per tuple are accepted
+ */
+static int sim_get_rows (struct sim *o, size_t cell, size_t ncols, char *rows)
+{
+	const struct cell *c = o->nl->cell[cell];
+	const struct tuple *t;
+	size_t i, j, len, pos;
+	char *row;
+
+	for (i = 0; i < c->ntuples; ++i) {
+		t   = c->tuple + i;
+		row = rows + i * ncols;
+
+		for (j = 0, pos = 0; j < t->size; ++j, pos += len) {
+			if ((len = strlen (t->m[j])) > ncols - pos)
+				goto wrong;
+
+			memcpy (row + pos, t->m[j], len);
+		}
+
+		if (pos != ncols)
+			goto wrong;
+
+		for (j = 0; j < ncols; ++j)
+			if (row[j] != '0' && row[j] != '1' && row[j] != '-')
+				goto wrong;
+	}
+
+	return 1;
+wrong:
+	return model_error (o->nl->model, "wrong row %zu of table %s", i,
+			    c->name);
+}
+
+static int sim_emit_lut (struct sim *o, size_t cell, size_t out,
+			 size_t ninputs, uint64_t mask)
+{
+	const struct netlist *nl = o->nl;
+	const size_t first = nl->cell_pin[cell];
+	size_t i;
+	int ok = 1;
+
+	ok &= sim_emit (o, SIM_LUT);
+	ok &= sim_emit (o, nl->pin_net[first + out]);
+	ok &= sim_emit (o, ninputs);
+	ok &= sim_emit (o, mask);
+
+	for (i = 0; i < ninputs; ++i)
+		ok &= sim_emit (o, nl->pin_net[first + i]);
+
+	return ok ? 1 : model_error (nl->model, NULL);
+}
+
+static size_t sim_count_lits (const struct netlist *nl, size_t first,
+			      size_t ncols, const char *row)
+{
+	size_t j, nlits;
+
+	for (j = 0, nlits = 0; j < ncols; ++j)
+		nlits += nl->pin_dir[first + j] == NL_IN && row[j] != '-';
+
+	return nlits;
+}
+
+/*
+ * Truth table is used if its tree of 2^n - 1 multiplexers, three
+ * operations each, is cheaper than sum of products
+ */
+static int
+sim_emit_output (struct sim *o, size_t cell, size_t out, size_t ncols,
+		 const char *rows, size_t ninputs, const uint64_t *lut)
+{
+	const struct netlist *nl = o->nl;
+	const size_t first = nl->cell_pin[cell];
+	const size_t nrows = nl->cell[cell]->ntuples;
+	size_t ncubes, cost, i, j;
+	const char *row;
+	int ok = 1;
+	char on;
+
+	for (i = 0, ncubes = 0; i < nrows; ++i)
+		ncubes += rows[i * ncols + out] == '1';
+
+	on = ncubes > 0 ? '1' : '0';
+
+	for (i = 0, ncubes = 0, cost = 0; i < nrows; ++i)
+		if ((row = rows + i * ncols)[out] == on) {
+			++ncubes;
+			cost += sim_count_lits (nl, first, ncols, row) * 2 + 1;
+		}
+
+	if (lut != NULL && ((size_t) 3 << ninputs) < cost)
+		return sim_emit_lut (o, cell, out, ninputs,
+				     lut[out - ninputs]);
+
+	if (ncubes == 0)  /* constant zero if neither set is given */
+		on = '1';
+
+	ok &= sim_emit (o, SIM_SOP);
+	ok &= sim_emit (o, nl->pin_net[first + out]);
+	ok &= sim_emit (o, on == '0');
+	ok &= sim_emit (o, ncubes);
+
+	for (i = 0; i < nrows; ++i) {
+		if ((row = rows + i * ncols)[out] != on)
+			continue;
+
+		ok &= sim_emit (o, sim_count_lits (nl, first, ncols, row));
+
+		for (j = 0; j < ncols; ++j)
+			if (nl->pin_dir[first + j] == NL_IN && row[j] != '-')
+				ok &= sim_emit (o, nl->pin_net[first + j] * 2 +
+						   (row[j] == '0'));
+	}
+
+	return ok ? 1 : model_error (nl->model, NULL);
+}
+
+/*
+ * Wire made by .conn has no rows, it is a buffer
+ */
+static int sim_emit_wire (struct sim *o, size_t cell)
+{
+	const struct netlist *nl = o->nl;
+	const size_t first = nl->cell_pin[cell];
+	int ok = 1;
+
+	if (nl->cell_pin[cell + 1] - first != 2)
+		return model_error (nl->model, "wrong wire %s",
+				    nl->cell[cell]->name);
+
+	ok &= sim_emit (o, SIM_SOP);
+	ok &= sim_emit (o, nl->pin_net[first + 1]);
+	ok &= sim_emit (o, 0);
+	ok &= sim_emit (o, 1);
+	ok &= sim_emit (o, 1);
+	ok &= sim_emit (o, nl->pin_net[first] * 2);
+
+	return ok ? 1 : model_error (nl->model, NULL);
+}
+
+static int sim_emit_table (struct sim *o, size_t cell)
+{
+	const struct netlist *nl = o->nl;
+	struct cell *c = nl->cell[cell];
+	const char *kind = cell_get_attr (c, "cell-kind");
+	const size_t first = nl->cell_pin[cell];
+	const size_t ncols = nl->cell_pin[cell + 1] - first;
+	const uint64_t *lut;
+	size_t i, ninputs;
+	char *rows;
+	int ok = 1;
+
+	if (c->ntuples == 0 && kind != NULL && strcmp (kind, "conn") == 0)
+		return sim_emit_wire (o, cell);
+
+	if ((rows = array_alloc (rows, c->ntuples * ncols)) == NULL)
+		return model_error (nl->model, NULL);
+
+	if (!sim_get_rows (o, cell, ncols, rows))
+		goto error;
+
+	for (i = 0, ninputs = 0; i < ncols; ++i)
+		ninputs += nl->pin_dir[first + i] == NL_IN;
+
+	lut = ninputs <= CELL_LUT_INPUTS ? cell_get_lut (c) : NULL;
+
+	for (i = ninputs; i < ncols; ++i)
+		ok &= sim_emit_output (o, cell, i, ncols, rows, ninputs, lut);
+
+	dakota_free (rows);
+	return ok;
+error:
+	dakota_free (rows);
+	return 0;
+}
+
+static int sim_is_table (const struct netlist *nl, size_t pin)
+{
+	return pin != NL_NONE && nl->cell_kind[nl->pin_cell[pin]] == NL_TABLE;
+}
+
+/*
+ * Levelize tables by Kahn: a table is ready when all of its input pins
+ * driven by other tables are evaluated; tables left are in a loop
+ */
+static int sim_levelize (struct sim *o, size_t *wait, size_t *queue)
+{
+	const struct netlist *nl = o->nl;
+	size_t head = 0, tail = 0, ntables = 0, c, i, j, net;
+
+	for (c = 0; c < nl->ncells; ++c) {
+		if (nl->cell_kind[c] != NL_TABLE)
+			continue;
+
+		++ntables;
+		wait[c] = 0;
+
+		for (i = nl->cell_pin[c]; i < nl->cell_pin[c + 1]; ++i)
+			if (nl->pin_dir[i] == NL_IN &&
+			    sim_is_table (nl, nl->net_driver[nl->pin_net[i]]))
+				++wait[c];
+
+		if (wait[c] == 0)
+			queue[tail++] = c;
+	}
+
+	for (; head < tail; ++head) {
+		c = queue[head];
+
+		if (!sim_emit_table (o, c))
+			return 0;
+
+		for (i = nl->cell_pin[c]; i < nl->cell_pin[c + 1]; ++i) {
+			if (nl->pin_dir[i] != NL_OUT)
+				continue;
+
+			net = nl->pin_net[i];
+
+			for (j = nl->net_load[net]; j < nl->net_load[net + 1]; ++j)
+				if (sim_is_table (nl, nl->load[j]) &&
+				    --wait[nl->pin_cell[nl->load[j]]] == 0)
+					queue[tail++] = nl->pin_cell[nl->load[j]];
+		}
+	}
+
+	if (tail == ntables)
+		return 1;
+
+	for (c = 0; nl->cell_kind[c] != NL_TABLE || wait[c] == 0; ++c) {}
+
+	return model_error (nl->model, "combinational loop through table %s",
+			    nl->cell[c]->name);
+}
+
+static int sim_compile (struct sim *o)
+{
+	const struct netlist *nl = o->nl;
+	size_t c, *wait, *queue;
+	int ok;
+
+	for (c = 0; c < nl->ncells; ++c)
+		switch (nl->cell_kind[c]) {
+		case NL_LATCH:
+			o->latch[o->nlatches++] = c;
+			break;
+		case NL_SUBCKT:
+			return model_error (nl->model, "cannot simulate cell %s "
+					    "of model %s, flatten it first",
+					    nl->cell[c]->name,
+					    nl->cell[c]->type);
+		}
+
+	wait  = array_alloc (wait,  nl->ncells);
+	queue = array_alloc (queue, nl->ncells);
+
+	ok = wait != NULL && queue != NULL ? sim_levelize (o, wait, queue) :
+	     model_error (nl->model, NULL);
+
+	dakota_free (wait);
+	dakota_free (queue);
+	return ok;
+}
+
+struct sim *sim_alloc (struct netlist *nl)
+{
+	struct sim *o;
+
+	if ((o = dakota_zalloc (ALLOC_MODEL, sizeof (*o))) == NULL)
+		goto no_mem;
+
+	o->nl    = nl;
+	o->value = array_alloc (o->value, nl->nnets);
+	o->latch = array_alloc (o->latch, nl->ncells);
+
+	if (o->value == NULL || o->latch == NULL)
+		goto no_mem;
+
+	if (!sim_compile (o))
+		goto error;
+
+	if ((o->next = array_alloc (o->next, o->nlatches)) == NULL)
+		goto no_mem;
+
+	sim_reset (o);
+	return o;
+no_mem:
+	model_error (nl->model, NULL);
+error:
+	sim_free (o);
+	return NULL;
+}
+
+static void sim_set_param (struct sim *o, const char *name, int value)
+{
+	const size_t net = netlist_get_net (o->nl, name);
+
+	if (net != NL_NONE)
+		o->value[net] = value == '1' ? ~0ULL : 0;
+}
+
+void sim_reset (struct sim *o)
+{
+	const struct model *m = o->nl->model;
+	const struct cell *c;
+	const char *init;
+	size_t i, j;
+	char *name;
+
+	memset (o->value, 0, sizeof (o->value[0]) * o->nl->nnets);
+
+	for (i = 0; i < m->nparams; ++i) {
+		if (strlen (m->param[i].value) == 1) {
+			sim_set_param (o, m->param[i].key, m->param[i].value[0]);
+			continue;
+		}
+
+		for (j = 0; m->param[i].value[j] != '\0'; ++j)
+			if ((name = make_string ("%s[%zu]", m->param[i].key,
+						 j)) != NULL) {
+				sim_set_param (o, name, m->param[i].value[j]);
+				free (name);
+			}
+	}
+
+	for (i = 0; i < o->nlatches; ++i) {
+		c = o->nl->cell[o->latch[i]];
+		init = c->nbinds == 3 ? c->bind[2].value :
+		       c->nbinds == 5 ? c->bind[4].value : "0";
+
+		if (strcmp (init, "1") == 0)
+			o->value[o->nl->pin_net[o->nl->cell_pin[o->latch[i]] +
+						NL_LATCH_Q]] = ~0ULL;
+	}
+
+	sim_eval (o);
+}
+
+void sim_set (struct sim *o, size_t net, uint64_t value)
+{
+	o->value[net] = value;
+}
+
+uint64_t sim_get (const struct sim *o, size_t net)
+{
+	return o->value[net];
+}
+
+static const uint64_t *
+sim_eval_sop (uint64_t *v, const uint64_t *pc)
+{
+	const uint64_t net = *pc++, invert = *pc++;
+	uint64_t acc, cube, ncubes, nlits, lit;
+
+	for (acc = 0, ncubes = *pc++; ncubes > 0; --ncubes) {
+		for (cube = ~0ULL, nlits = *pc++; nlits > 0; --nlits) {
+			lit   = *pc++;
+			cube &= v[lit >> 1] ^ -(lit & 1);
+		}
+
+		acc |= cube;
+	}
+
+	v[net] = invert ? ~acc : acc;
+	return pc;
+}
+
+/*
+ * Every step of multiplexer tree selects by the next input between
+ * adjacent entries, as input k is bit k of truth table index
+ */
+static const uint64_t *
+sim_eval_lut (uint64_t *v, const uint64_t *pc)
+{
+	const uint64_t net = *pc++, ninputs = *pc++, mask = *pc++;
+	uint64_t t[1 << CELL_LUT_INPUTS], x;
+	size_t i, j, n = (size_t) 1 << ninputs;
+
+	for (i = 0; i < n; ++i)
+		t[i] = -(mask >> i & 1);
+
+	for (j = 0; j < ninputs; ++j) {
+		x = v[pc[j]];
+		n /= 2;
+
+		for (i = 0; i < n; ++i)
+			t[i] = (t[2 * i] & ~x) | (t[2 * i + 1] & x);
+	}
+
+	v[net] = t[0];
+	return pc + ninputs;
+}
+
+void sim_eval (struct sim *o)
+{
+	const uint64_t *pc = o->code, *end = o->code + o->ncode;
+
+	while (pc < end)
+		pc = *pc == SIM_LUT ? sim_eval_lut (o->value, pc + 1) :
+				      sim_eval_sop (o->value, pc + 1);
+}
+
+/*
+ * Latch all data inputs first as output of one latch may feed another
+ */
+void sim_step (struct sim *o)
+{
+	const struct netlist *nl = o->nl;
+	size_t i, pin;
+
+	for (i = 0; i < o->nlatches; ++i) {
+		pin = nl->cell_pin[o->latch[i]];
+		o->next[i] = o->value[nl->pin_net[pin + NL_LATCH_D]];
+	}
+
+	for (i = 0; i < o->nlatches; ++i) {
+		pin = nl->cell_pin[o->latch[i]];
+		o->value[nl->pin_net[pin + NL_LATCH_Q]] = o->next[i];
+	}
+
+	sim_eval (o);
+}
@@ -1,28 +1,117 @@
 /*
  * Dakota Model Parser Test
  *
- * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
  *
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
 #include <err.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <dakota/model.h>
+#include <dakota/model/cell.h>
+#include <dakota/model/netlist.h>
+
+/*
+ * Loaded model must have the same nets, as connect left them, and the
+ * same cells bound to the same nets
+ */
+static void compare (struct model *a, struct model *b)
+{
+	struct netlist *x, *y;
+	size_t i;
+
+	if ((x = netlist_alloc (a)) == NULL)
+		errx (1, "%s", model_status (a));
+
+	if ((y = netlist_alloc (b)) == NULL)
+		errx (1, "%s", model_status (b));
+
+	if (x->nnets != y->nnets || x->ncells != y->ncells ||
+	    x->npins != y->npins)
+		errx (1, "binary: netlist size differs");
+
+	for (i = 0; i < x->nnets; ++i)
+		if (strcmp (x->net_name[i], y->net_name[i]) != 0 ||
+		    x->net_type[i] != y->net_type[i] ||
+		    x->net_driver[i] != y->net_driver[i])
+			errx (1, "binary: net %s differs", x->net_name[i]);
+
+	for (i = 0; i < x->ncells; ++i)
+		if (strcmp (x->cell[i]->type, y->cell[i]->type) != 0 ||
+		    strcmp (x->cell[i]->name, y->cell[i]->name) != 0 ||
+		    x->cell_pin[i] != y->cell_pin[i])
+			errx (1, "binary: cell %s differs", x->cell[i]->name);
+
+	for (i = 0; i < x->npins; ++i)
+		if (x->pin_net[i] != y->pin_net[i])
+			errx (1, "binary: pin %zu differs", i);
+
+	netlist_free (x);
+	netlist_free (y);
+}
+
+/*
+ * Save model in binary form and load it back
+ */
+static struct model *reload (struct model *o)
+{
+	char path[] = "/tmp/model-test-XXXXXX";
+	struct model *copy;
+	int fd;
+
+	if ((fd = mkstemp (path)) < 0)
+		err (1, "cannot create temporary file");
+
+	close (fd);
+
+	if (!model_write_binary (o, path))
+		errx (1, "%s", model_status (o));
+
+	if ((copy = model_load_binary (path)) == NULL)
+		err (1, "cannot load model from %s", path);
+
+	unlink (path);
+	compare (o, copy);
+	model_free (o);
+	return copy;
+}
+
+static void usage (void)
+{
+	errx (1, "\n\tmodel-test [-b] <input-file>");
+}
 
 int main (int argc, char *argv[])
 {
 	struct model *o;
+	int c, binary = 0;
+
+	while ((c = getopt (argc, argv, "b")) != -1)
+		switch (c) {
+		case 'b':
+			binary = 1;
+			break;
+		default:
+			usage ();
+		}
 
-	if (argc != 2)
-		errx (1, "\n\tmodel-read-test <input-file>");
+	if (argc - optind != 1)
+		usage ();
 
-	if ((o = model_read (argv[1])) == NULL)
-		err (1, "cannot create model from %s", argv[1]);
+	if ((o = model_read (argv[optind])) == NULL)
+		err (1, "cannot create model from %s", argv[optind]);
 
 	if (model_status (o) != NULL)
 		errx (1, "%s", model_status (o));
 
+	if (binary)
+		o = reload (o);
+
 	if (!model_write (o, "-"))
 		errx (1, "%s", model_status (o));
 
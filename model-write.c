@@ -6,94 +6,151 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <dakota/model.h>
 
 #include "model-core.h"
 
-static int model_write_params (struct model *o, FILE *out)
+/*
+ * Output is collected into one large buffer and passed to sink in big
+ * chunks, errors are sticky thus every token is put unconditionally and
+ * the result is checked once at the end
+ */
+#define WRITER_SIZE	65536
+
+struct writer {
+	model_sink_fn *sink;
+	void *cookie;
+	size_t len;
+	int ok;
+	char buf[WRITER_SIZE];
+};
+
+static void writer_flush (struct writer *o)
 {
-	const char *name, *value;
-	size_t i;
-	int ok = 1;
+	if (o->ok && o->len > 0)
+		o->ok = o->sink (o->cookie, o->buf, o->len);
+
+	o->len = 0;
+}
 
-	for (i = 0; i < o->nparams; ++i) {
-		name  = o->param[i].key;
-		value = o->param[i].value;
+static void put_data (struct writer *o, const char *s, size_t len)
+{
+	if (len > sizeof (o->buf) - o->len) {
+		writer_flush (o);
 
-		ok &= (value != NULL) ?
-		      fprintf (out, ".param %s %s\n", name, value) > 0 :
-		      fprintf (out, ".param %s\n",    name) > 0;
+		if (len >= sizeof (o->buf)) {
+			o->ok = o->ok && o->sink (o->cookie, s, len);
+			return;
+		}
 	}
 
-	return ok;
+	memcpy (o->buf + o->len, s, len);
+	o->len += len;
+}
+
+static void put_char (struct writer *o, char c)
+{
+	if (o->len == sizeof (o->buf))
+		writer_flush (o);
+
+	o->buf[o->len++] = c;
+}
+
+static void put (struct writer *o, const char *s)
+{
+	put_data (o, s, strlen (s));
 }
 
-static int model_write_inputs (struct model *o, FILE *out)
+static void put_pair (struct writer *o, const char *prefix, const char *name,
+		      const char *value)
 {
-	const char *prefix, *name;
+	put (o, prefix);
+	put (o, name);
+
+	if (value != NULL) {
+		put_char (o, ' ');
+		put (o, value);
+	}
+
+	put_char (o, '\n');
+}
+
+static void model_write_params (struct model *o, struct writer *out)
+{
+	size_t i;
+
+	for (i = 0; i < o->nparams; ++i)
+		put_pair (out, ".param ", o->param[i].key, o->param[i].value);
+}
+
+static void model_write_inputs (struct model *o, struct writer *out)
+{
+	const char *prefix;
+	struct port *p;
 	size_t i;
-	int ok = 1;
 
-	for (i = 0, prefix = ".inputs "; i < o->nports; ++i)
-		if ((o->port[i].type & (PORT_INPUT | PORT_LOCAL)) == PORT_INPUT) {
-			name = o->port[i].name;
-			ok &= fprintf (out, "%s%s", prefix, name) > 0;
+	for (i = 0, prefix = ".inputs "; i < o->port.count; ++i)
+		if (((p = model_port (o, i))->type &
+		     (PORT_INPUT | PORT_LOCAL)) == PORT_INPUT) {
+			put (out, prefix);
+			put (out, p->name);
 			prefix = " ";
 		}
 
 	if (prefix[0] == ' ')
-		ok &= fprintf (out, "\n") > 0;
-
-	return ok;
+		put_char (out, '\n');
 }
 
-static int model_write_outputs (struct model *o, FILE *out)
+static void model_write_outputs (struct model *o, struct writer *out)
 {
-	const char *prefix, *name;
+	const char *prefix;
+	struct port *p;
 	size_t i;
-	int ok = 1;
 
-	for (i = 0, prefix = ".outputs "; i < o->nports; ++i)
-		if ((o->port[i].type & (PORT_INPUT | PORT_LOCAL)) == 0) {
-			name = o->port[i].name;
-			ok &= fprintf (out, "%s%s", prefix, name) > 0;
+	for (i = 0, prefix = ".outputs "; i < o->port.count; ++i)
+		if (((p = model_port (o, i))->type &
+		     (PORT_INPUT | PORT_LOCAL)) == 0) {
+			put (out, prefix);
+			put (out, p->name);
 			prefix = " ";
 		}
 
 	if (prefix[0] == ' ')
-		ok &= fprintf (out, "\n") > 0;
-
-	return ok;
+		put_char (out, '\n');
 }
 
-static int cell_write_binds (struct cell *o, FILE *out)
+static void cell_write_binds (struct cell *o, struct writer *out)
 {
 	size_t i;
 	const char *port, *value;
-	int ok = 1;
 
 	for (i = 0; i < o->nbinds; ++i) {
 		port  = o->bind[i].key;
 		value = o->bind[i].value;
 
-		if (port == NULL)
-			ok &= fprintf (out, " %s", value) > 0;
-		else
-			ok &= fprintf (out, " %s=%s", port, value) > 0;
+		put_char (out, ' ');
+
+		if (port != NULL) {
+			put (out, port);
+			put_char (out, '=');
+		}
+
+		put (out, value);
 	}
 
-	ok &= fprintf (out, "\n") > 0;
-	return ok;
+	put_char (out, '\n');
 }
 
-static int cell_write_attrs (struct cell *o, FILE *out)
+static void cell_write_attrs (struct cell *o, struct writer *out)
 {
 	const char *name, *value;
 	size_t i;
-	int ok = 1;
 
 	for (i = 0; i < o->nattrs; ++i) {
 		name  = o->attr[i].key;
@@ -103,53 +160,37 @@ static int cell_write_attrs (struct cell *o, FILE *out)
 			continue;
 
 		if (strcmp (name, "cname") == 0)
-			ok &= fprintf (out, ".cname %s\n", value) > 0;
-		else
-		if (value != NULL)
-			ok &= fprintf (out, ".attr %s %s\n", name, value) > 0;
+			put_pair (out, ".cname ", value, NULL);
 		else
-			ok &= fprintf (out, ".attr %s\n", name) > 0;
+			put_pair (out, ".attr ", name, value);
 	}
-
-	return ok;
 }
 
-static int cell_write_params (struct cell *o, FILE *out)
+static void cell_write_params (struct cell *o, struct writer *out)
 {
-	const char *name, *value;
 	size_t i;
-	int ok = 1;
-
-	for (i = 0; i < o->nparams; ++i) {
-		name  = o->param[i].key;
-		value = o->param[i].value;
 
-		if (value != NULL)
-			ok &= fprintf (out, ".param %s %s\n", name, value) > 0;
-		else
-			ok &= fprintf (out, ".param %s\n", name) > 0;
-	}
-
-	return ok;
+	for (i = 0; i < o->nparams; ++i)
+		put_pair (out, ".param ", o->param[i].key, o->param[i].value);
 }
 
-static int cell_write_tuples (struct cell *o, FILE *out)
+static void cell_write_tuples (struct cell *o, struct writer *out)
 {
 	size_t i, j;
-	const char *sep;
 	const struct tuple *tuple;
-	int ok = 1;
 
 	for (i = 0; i < o->ntuples; ++i) {
 		tuple = o->tuple + i;
 
-		for (j = 0, sep = ""; j < tuple->size; ++j, sep = "\t")
-			ok &= fprintf (out, "%s%s", sep, tuple->m[j]) > 0;
+		for (j = 0; j < tuple->size; ++j) {
+			if (j > 0)
+				put_char (out, '\t');
 
-		ok &= fprintf (out, "\n") > 0;
-	}
+			put (out, tuple->m[j]);
+		}
 
-	return ok;
+		put_char (out, '\n');
+	}
 }
 
 static const char *cell_get_kind (struct cell *o)
@@ -168,83 +209,104 @@ static const char *cell_get_kind (struct cell *o)
 	return "subckt";
 }
 
-static int model_write_cell (struct model *o, size_t i, FILE *out)
+static void model_write_cell (struct model *o, size_t i, struct writer *out)
 {
+	struct cell *c = model_cell (o, i);
 	const char *kind, *type;
-	int ok = 1;
 
-	kind = cell_get_kind (o->cell + i);
-	type = o->cell[i].type;
+	kind = cell_get_kind (c);
+	type = c->type;
 
-	if (strcmp (type, "table") == 0 || strcmp (type, "latch") == 0)
-		ok &= fprintf (out, ".%s", kind) > 0;
-	else
-		ok &= fprintf (out, ".%s %s", kind, type) > 0;
+	put_char (out, '.');
+	put (out, kind);
 
-	ok &= cell_write_binds  (o->cell + i, out);
-	ok &= cell_write_attrs  (o->cell + i, out);
-	ok &= cell_write_params (o->cell + i, out);
-	ok &= cell_write_tuples (o->cell + i, out);
+	if (strcmp (type, "table") != 0 && strcmp (type, "latch") != 0) {
+		put_char (out, ' ');
+		put (out, type);
+	}
 
-	return ok;
+	cell_write_binds  (c, out);
+	cell_write_attrs  (c, out);
+	cell_write_params (c, out);
+	cell_write_tuples (c, out);
 }
 
-static int model_write_cells (struct model *o, FILE *out)
+static void model_write_cells (struct model *o, struct writer *out)
 {
 	size_t i;
-	int ok = 1;
 
-	for (i = 0; i < o->ncells; ++i)
-		ok &= model_write_cell (o, i, out);
+	for (i = 0; i < o->cell.count; ++i)
+		model_write_cell (o, i, out);
+}
+
+static void model_write_one (struct model *o, struct writer *out)
+{
+	put_pair (out, ".model ", o->name, NULL);
+
+	model_write_params  (o, out);
+	model_write_inputs  (o, out);
+	model_write_outputs (o, out);
+	model_write_cells   (o, out);
 
-	return ok;
+	put (out, ".end\n");
 }
 
-static int model_write_one (struct model *o, FILE *out)
+int model_write_sink (struct model *o, model_sink_fn *sink, void *cookie)
 {
-	int ok = 1;
+	struct writer out;
+	size_t i;
 
-	ok &= fprintf (out, ".model %s\n", o->name) > 0;
+	out.sink   = sink;
+	out.cookie = cookie;
+	out.len    = 0;
+	out.ok     = 1;
 
-	ok &= model_write_params  (o, out);
-	ok &= model_write_inputs  (o, out);
-	ok &= model_write_outputs (o, out);
-	ok &= model_write_cells   (o, out);
+	model_write_one (o, &out);
 
-	ok &= fprintf (out, ".end\n") > 0;
+	for (i = 0; i < o->model.count && out.ok; ++i) {
+		put_char (&out, '\n');
+		model_write_one (model_sub (o, i), &out);
+	}
 
-	return ok;
+	writer_flush (&out);
+	return out.ok;
 }
 
-int model_write (struct model *o, const char *path)
+static int write_fd (void *cookie, const void *data, size_t size)
 {
-	FILE *out;
-	size_t i;
+	const int fd = *(int *) cookie;
+	const char *p = data;
+	ssize_t len;
+
+	for (; size > 0; p += len, size -= len)
+		if ((len = write (fd, p, size)) < 0) {
+			if (errno == EINTR)
+				len = 0;
+			else
+				return 0;
+		}
 
-	if (strcmp (path, "-") == 0)
-		out = stdout;
-	else
-	if ((out = fopen (path, "w")) == NULL)
-		return model_error (o, NULL);
+	return 1;
+}
 
-	if (!model_write_one (o, out))
-		goto error;
+int model_write (struct model *o, const char *path)
+{
+	int fd, ok;
 
-	for (i = 0; i < o->nmodels; ++i) {
-		fprintf (out, "\n");
+	if (strcmp (path, "-") == 0) {
+		if (fflush (stdout) != 0)
+			return model_error (o, NULL);
 
-		if (!model_write_one (o->model + i, out))
-			goto error;
+		fd = STDOUT_FILENO;
 	}
-
-	if (fclose (out) != 0)
+	else
+	if ((fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
 		return model_error (o, NULL);
 
-	return 1;
-error:
-	if (out != stdout) {
-		fclose (out);
-	}
+	ok = model_write_sink (o, write_fd, &fd);
+
+	if (fd != STDOUT_FILENO && close (fd) != 0)
+		ok = 0;
 
-	return 0;
+	return ok ? 1 : model_error (o, NULL);
 }
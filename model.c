@@ -8,6 +8,7 @@
 
 #include <stdlib.h>
 
+#include <dakota/alloc.h>
 #include <dakota/error.h>
 
 #include "model-connect.h"
@@ -17,7 +18,7 @@ struct model *model_alloc (struct model *parent, const char *name)
 {
 	struct model *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	if ((o = dakota_alloc (ALLOC_MODEL, sizeof (*o))) == NULL)
 		return NULL;
 
 	if (!model_init (o, parent, name))
@@ -25,7 +26,7 @@ struct model *model_alloc (struct model *parent, const char *name)
 
 	return o;
 no_init:
-	free (o);
+	dakota_free (o);
 	return NULL;
 }
 
@@ -35,7 +36,7 @@ void model_free (struct model *o)
 		return;
 
 	model_fini (o);
-	free (o);
+	dakota_free (o);
 }
 
 int model_error (struct model *o, const char *fmt, ...)
@@ -56,5 +57,7 @@ const char *model_status (struct model *o)
 
 int model_commit (struct model *o)
 {
+	model_shrink (o);
+
 	return model_connect (o);
 }
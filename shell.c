@@ -6,26 +6,86 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <errno.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <dakota/file.h>
 #include <dakota/shell.h>
 
+/*
+ * Regular files are loaded whole into private writable buffer, mapped
+ * if there is room for terminating zero in the last page, and words are
+ * unescaped in place, thus argv points into buffer. Other inputs are
+ * read by characters from stream and words are collected into line.
+ */
 struct shell {
 	FILE *in;
 	size_t nchars, last;
 	char *line;
 	size_t nwords;
 	struct shell_cmd cmd;
+
+	char *buf, *p, *end;	/* file buffer, *end is zero */
+	size_t mapped;		/* size of mapping, zero if allocated */
 };
 
+/*
+ * Returns 1 if file is loaded, zero to fall back to stdio when there is
+ * no regular file or memory for it, and -1 if file cannot be read: its
+ * position is lost then
+ */
+static int shell_load (struct shell *o, FILE *in)
+{
+	const long page = sysconf (_SC_PAGESIZE);
+	struct stat st;
+	size_t size;
+	void *p;
+
+	if (fstat (fileno (in), &st) != 0 || !S_ISREG (st.st_mode) ||
+	    (uintmax_t) st.st_size >= SIZE_MAX)
+		return 0;
+
+	size = st.st_size;
+
+	if (page > 0 && size % page != 0) {
+		p = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+			  fileno (in), 0);
+
+		if (p != MAP_FAILED) {
+			madvise (p, size, MADV_SEQUENTIAL);
+			o->mapped = size;
+			goto done;
+		}
+	}
+
+	if ((p = malloc (size + 1)) == NULL)
+		return 0;
+
+	if (fread (p, 1, size, in) != size) {
+		if (!ferror (in))
+			errno = EIO;  /* file shrank while read */
+
+		free (p);
+		return -1;
+	}
+done:
+	o->buf = o->p = p;
+	o->end = o->buf + size;
+	*o->end = '\0';
+	return 1;
+}
+
 struct shell *shell_alloc (const char *category, const char *path)
 {
 	struct shell *o;
+	int loaded;
 
 	if ((o = malloc (sizeof (*o))) == NULL)
 		return NULL;
@@ -41,7 +101,20 @@ struct shell *shell_alloc (const char *category, const char *path)
 	o->nwords     = 0;
 	o->cmd.argv   = NULL;
 	o->cmd.lineno = 0;
+	o->buf        = NULL;
+	o->mapped     = 0;
+
+	if (o->in != stdin && (loaded = shell_load (o, o->in)) != 0) {
+		if (loaded < 0)
+			goto no_load;
+
+		fclose (o->in);
+		o->in = NULL;
+	}
+
 	return o;
+no_load:
+	fclose (o->in);
 no_file:
 	free (o);
 	return NULL;
@@ -52,7 +125,14 @@ void shell_free (struct shell *o)
 	if (o == NULL)
 		return;
 
-	fclose (o->in);
+	if (o->in != NULL)
+		fclose (o->in);
+
+	if (o->mapped > 0)
+		munmap (o->buf, o->mapped);
+	else
+		free (o->buf);
+
 	free (o->line);
 	free (o->cmd.argv);
 	free (o);
@@ -132,12 +212,12 @@ static int resize_words (struct shell *o, size_t count)
 	return 1;
 }
 
-static int push_word (struct shell *o)
+static int push_word (struct shell *o, char *word)
 {
 	if (!resize_words (o, o->cmd.argc + 1))
 		return 0;
 
-	o->cmd.argv[o->cmd.argc++] = o->line + o->last;
+	o->cmd.argv[o->cmd.argc++] = word;
 	return 1;
 }
 
@@ -200,7 +280,7 @@ w_start:
 	default:	goto w_head;
 	}
 string:
-	if (!push_word (o))
+	if (!push_word (o, o->line + o->last))
 		return 0;
 
 	goto s_first;
@@ -220,7 +300,7 @@ s_escape:
 	default:	goto s_next;
 	}
 w_head:
-	if (!push_word (o))
+	if (!push_word (o, o->line + o->last))
 		return 0;
 w_next:
 	if (!push_char (o, a))
@@ -258,12 +338,175 @@ end:
 	goto l_start;
 }
 
+/*
+ * Buffer backend: the same grammar as above, runs of plain characters
+ * are found with strcspn and moved down over removed escapes, thus
+ * written position never passes read position
+ */
+static int map_get_char (struct shell *o)
+{
+	return o->p < o->end ? (unsigned char) *o->p++ : EOF;
+}
+
+static int map_skip_comment (struct shell *o)
+{
+	char *p;
+
+	if ((p = memchr (o->p, '\n', o->end - o->p)) == NULL) {
+		o->p = o->end;
+		return EOF;
+	}
+
+	o->p = p + 1;
+	return '\n';
+}
+
+static int map_word_char (struct shell *o)
+{
+	int a;
+
+	for (;;) {
+		if ((a = map_get_char (o)) == '#')
+			return map_skip_comment (o);
+
+		if (a != '\\')
+			return a;
+
+		if (o->p == o->end || *o->p != '\n')
+			return '\\';
+
+		++o->p;
+		++o->cmd.lineno;
+	}
+}
+
+static size_t map_copy (struct shell *o, char *w, const char *set)
+{
+	size_t n = strcspn (o->p, set);
+
+	if (w != o->p)
+		memmove (w, o->p, n);
+
+	o->p += n;
+	return n;
+}
+
+static int map_word (struct shell *o, char *w)
+{
+	int a;
+
+	for (;;) {
+		w += map_copy (o, w, " \t\n#\\");
+
+		if (o->p == o->end) {
+			a = EOF;
+			break;
+		}
+
+		switch (a = (unsigned char) *o->p++) {
+		case '\t':
+		case '\n':
+		case ' ':
+			goto tail;
+		case '#':
+			a = map_skip_comment (o);
+			goto tail;
+		case '\\':
+			if (o->p < o->end && *o->p == '\n') {
+				++o->p;
+				++o->cmd.lineno;
+				continue;
+			}
+			/* fall through */
+		default:
+			*w++ = a;  /* backslash or zero byte */
+		}
+	}
+tail:
+	*w = '\0';
+	return a;
+}
+
+static int map_string (struct shell *o, char *w)
+{
+	int a;
+
+	for (;;) {
+		w += map_copy (o, w, "\"\\");
+
+		if ((a = map_get_char (o)) == EOF || a == '"')
+			break;
+
+		if (a == '\\' && (a = map_get_char (o)) == EOF)
+			break;
+
+		*w++ = a;
+	}
+
+	*w = '\0';
+	return a;
+}
+
+static size_t map_get_word (struct shell *o)
+{
+	int a;
+l_start:
+	for (o->cmd.indent = 0; o->p < o->end; ++o->p)
+		if (*o->p == ' ')
+			++o->cmd.indent;
+		else
+		if (*o->p == '\t')
+			o->cmd.indent = (o->cmd.indent + 8) & ~7;
+		else
+			break;
+w_start:
+	switch (a = map_word_char (o)) {
+	case EOF:
+	case '\n':
+		goto end;
+	case '\t':
+	case ' ':
+		goto w_start;
+	case '"':
+		if (!push_word (o, o->p))
+			return 0;
+
+		a = map_string (o, o->p);
+		break;
+	default:
+		if (!push_word (o, o->p - 1))
+			return 0;
+
+		a = map_word (o, o->p);
+	}
+
+	debug ("got word %s", o->cmd.argv[o->cmd.argc - 1]);
+
+	if (a != '\n')
+		goto w_start;
+end:
+	++o->cmd.lineno;
+
+	if (o->cmd.argc > 0) {
+		debug ("got %zu words", o->cmd.argc);
+		return o->cmd.argc;
+	}
+
+	if (a == EOF) {
+		debug ("end of file");
+		return 0;
+	}
+
+	debug ("skip empty line");
+	goto l_start;
+}
+
 const struct shell_cmd *shell_next (struct shell *o)
 {
 	o->last     = 0;
 	o->cmd.argc = 0;
 
-	if (get_word (o) == 0)
+	if ((o->buf != NULL ? map_get_word (o) : get_word (o)) == 0)
 		return NULL;
 
 	return &o->cmd;
@@ -0,0 +1,247 @@
+/*
+ * Dakota Model Simulator Test
+ *
+ * Copyright (c) 2021-2022 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <err.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dakota/model.h>
+#include <dakota/model/cell.h>
+#include <dakota/model/port.h>
+#include <dakota/model/sim.h>
+
+static uint64_t seed = 1;
+
+static uint64_t rnd (void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 7;
+	seed ^= seed << 17;
+
+	return seed;
+}
+
+static double now (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int is_table_net (const struct netlist *nl, size_t net)
+{
+	const size_t pin = nl->net_driver[net];
+
+	return pin != NL_NONE && nl->cell_kind[nl->pin_cell[pin]] == NL_TABLE;
+}
+
+/*
+ * Concatenate row tuples into row of the given width
+ */
+static void get_row (const struct cell *cell, size_t i, char *row, size_t width)
+{
+	const struct tuple *t = cell->tuple + i;
+	size_t j, len, pos;
+
+	for (pos = 0, j = 0; j < t->size; pos += len, ++j)
+		if ((len = strlen (t->m[j])) > width - pos)
+			errx (1, "row %zu of table %s is too wide", i,
+			      cell->name);
+
+	if (pos != width)
+		errx (1, "row %zu of table %s is too narrow", i, cell->name);
+
+	for (pos = 0, j = 0; j < t->size; pos += len, ++j)
+		memcpy (row + pos, t->m[j], len = strlen (t->m[j]));
+}
+
+/*
+ * Reference: match rows one by one as written, concatenating row tuples
+ */
+static int ref_table (const struct netlist *nl, size_t c, char *v,
+		      char *row)
+{
+	const struct cell *cell = nl->cell[c];
+	const size_t first = nl->cell_pin[c], last = nl->cell_pin[c + 1];
+	const char *kind;
+	char on, out;
+	size_t i, j, p;
+	int match, changed = 0;
+
+	if ((kind = cell_get_attr (cell, "cell-kind")) != NULL &&
+	    strcmp (kind, "conn") == 0) {
+		changed = v[nl->pin_net[last - 1]] != v[nl->pin_net[first]];
+		v[nl->pin_net[last - 1]] = v[nl->pin_net[first]];
+		return changed;
+	}
+
+	for (p = first; p < last; ++p) {
+		if (nl->pin_dir[p] != NL_OUT)
+			continue;
+
+		for (on = '1', i = 0; i < cell->ntuples; ++i) {
+			get_row (cell, i, row, last - first);
+
+			if (row[p - first] == '1')
+				break;
+
+			if (row[p - first] == '0')
+				on = '0';
+		}
+
+		if (i < cell->ntuples)
+			on = '1';
+
+		for (out = on == '0', i = 0; i < cell->ntuples; ++i) {
+			get_row (cell, i, row, last - first);
+
+			for (match = 1, j = first; j < last; ++j)
+				if (nl->pin_dir[j] == NL_IN && row[j - first] != '-')
+					match &= row[j - first] - '0' ==
+						 v[nl->pin_net[j]];
+
+			if (match && row[p - first] == on)
+				out = on == '1';
+		}
+
+		changed |= v[nl->pin_net[p]] != out;
+		v[nl->pin_net[p]] = out;
+	}
+
+	return changed;
+}
+
+/*
+ * Evaluate tables in cell order until nothing changes and compare every
+ * net driven by a table with the given lane of simulator, row must hold
+ * pins of the widest cell
+ */
+static int check_lane (const struct netlist *nl, struct sim *s, int lane,
+		       char *v, char *row)
+{
+	size_t net, c, pass;
+	int changed;
+
+	for (net = 0; net < nl->nnets; ++net)
+		v[net] = is_table_net (nl, net) ? 0 : sim_get (s, net) >> lane & 1;
+
+	for (pass = 0, changed = 1; changed && pass <= nl->ncells; ++pass)
+		for (c = 0, changed = 0; c < nl->ncells; ++c)
+			if (nl->cell_kind[c] == NL_TABLE)
+				changed |= ref_table (nl, c, v, row);
+
+	for (net = 0; net < nl->nnets; ++net)
+		if (v[net] != (char) (sim_get (s, net) >> lane & 1)) {
+			warnx ("lane %d: net %s differs", lane, nl->net_name[net]);
+			return 0;
+		}
+
+	return 1;
+}
+
+static void set_inputs (const struct netlist *nl, struct sim *s)
+{
+	size_t net;
+
+	for (net = 0; net < nl->nnets; ++net)
+		if ((nl->net_type[net] & PORT_INPUT) != 0)
+			sim_set (s, net, rnd ());
+}
+
+static void usage (void)
+{
+	errx (1, "\n\tsim-test [-f] [-n <cycles>] <input-file> [<model>]");
+}
+
+int main (int argc, char *argv[])
+{
+	struct model *root, *m, *flat = NULL;
+	struct netlist *nl;
+	struct sim *s;
+	size_t cycles = 1000, width = 0, i;
+	const char *name;
+	char *v, *row;
+	double start;
+	int c, flatten = 0;
+
+	while ((c = getopt (argc, argv, "fn:")) != -1)
+		switch (c) {
+		case 'f':
+			flatten = 1;
+			break;
+		case 'n':
+			cycles = atol (optarg);
+			break;
+		default:
+			usage ();
+		}
+
+	if (argc - optind < 1 || argc - optind > 2)
+		usage ();
+
+	if ((root = model_read (argv[optind])) == NULL)
+		err (1, "cannot create model from %s", argv[optind]);
+
+	if (model_status (root) != NULL)
+		errx (1, "%s", model_status (root));
+
+	name = argv[optind + 1];
+
+	if ((m = name != NULL ? model_get_model (root, name) : root) == NULL)
+		errx (1, "cannot find model %s", name);
+
+	if (flatten) {
+		if ((flat = model_flatten (m)) == NULL)
+			errx (1, "%s", model_status (m));
+
+		m = flat;
+	}
+
+	if ((nl = netlist_alloc (m)) == NULL || (s = sim_alloc (nl)) == NULL)
+		errx (1, "%s", model_status (m));
+
+	for (i = 0; i < nl->ncells; ++i)
+		if (nl->cell_pin[i + 1] - nl->cell_pin[i] > width)
+			width = nl->cell_pin[i + 1] - nl->cell_pin[i];
+
+	if ((v = malloc (nl->nnets)) == NULL || (row = malloc (width + 1)) == NULL)
+		err (1, "cannot allocate reference");
+
+	for (i = 0; i < cycles; ++i) {
+		set_inputs (nl, s);
+		sim_eval (s);
+
+		if (!check_lane (nl, s, i % 64, v, row))
+			errx (1, "cycle %zu: simulation differs", i);
+
+		sim_step (s);
+	}
+
+	start = now ();
+
+	for (i = 0; i < cycles; ++i) {
+		set_inputs (nl, s);
+		sim_step (s);
+	}
+
+	printf ("sim: %zu cycles checked, %.0f vectors/s\n", cycles,
+		cycles * 64 / (now () - start + 1e-9));
+
+	free (row);
+	free (v);
+	sim_free (s);
+	netlist_free (nl);
+	model_free (flat);
+	model_free (root);
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Dakota Statistics
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <dakota/data/array.h>
+#include <dakota/stats.h>
+
+struct probe {
+	const char *name, *unit;
+	size_t count, items;
+	uint64_t time;
+};
+
+struct span {
+	int id;
+	uint64_t start, time;
+};
+
+static struct probe probe[STATS_COUNT] = {
+	[STATS_READ]	= { "read",	"records"	},
+	[STATS_LOOKUP]	= { "lookup",	"lookups"	},
+	[STATS_TILE]	= { "tile",	"tiles"		},
+	[STATS_RESIZE]	= { "resize",	"bytes"		},
+	[STATS_BLIT]	= { "blit",	"bytes"		},
+	[STATS_EXPORT]	= { "export",	"bytes"		},
+};
+
+static int trace;
+static uint64_t epoch;
+static size_t nspans, maxspans;
+static struct span *spans;
+
+#ifdef DAKOTA_NO_STATS
+static int stats_enabled;
+#else
+int stats_enabled;
+#endif
+
+uint64_t stats_clock (void)
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void stats_record (int id, uint64_t start, uint64_t time)
+{
+	size_t next = maxspans == 0 ? 4096 : maxspans * 2;
+	struct span *p;
+
+	if (nspans == maxspans) {
+		if ((p = array_resize (spans, next)) == NULL) {
+			trace = 0;  /* out of memory: stop tracing */
+			return;
+		}
+
+		spans    = p;
+		maxspans = next;
+	}
+
+	p = spans + nspans++;
+
+	p->id    = id;
+	p->start = start;
+	p->time  = time;
+}
+
+void stats_commit (int id, uint64_t start, size_t n)
+{
+	const uint64_t time = stats_clock () - start;
+
+	++probe[id].count;
+	probe[id].items += n;
+	probe[id].time  += time;
+
+	if (trace)
+		stats_record (id, start, time);
+}
+
+void stats_enable (int with_trace)
+{
+	stats_enabled = 1;
+	trace = with_trace;
+	epoch = stats_clock ();
+}
+
+void stats_reset (void)
+{
+	size_t i;
+
+	for (i = 0; i < STATS_COUNT; ++i) {
+		probe[i].count = 0;
+		probe[i].items = 0;
+		probe[i].time  = 0;
+	}
+
+	nspans = 0;
+	epoch  = stats_clock ();
+}
+
+int stats_report (FILE *out)
+{
+	const struct probe *p;
+	double ms, rate;
+	size_t i;
+	int ok = 1;
+
+	if (!stats_enabled)
+		return 1;
+
+	ok &= fprintf (out, "%-8s %10s %12s %14s %16s\n", "phase", "spans",
+		       "time, ms", "items", "rate, items/s") > 0;
+
+	for (i = 0, p = probe; i < STATS_COUNT; ++i, ++p) {
+		if (p->count == 0)
+			continue;
+
+		ms   = p->time / 1e6;
+		rate = p->time == 0 ? 0 : p->items * 1e9 / p->time;
+
+		ok &= fprintf (out, "%-8s %10zu %12.3f %14zu %16.0f %s\n",
+			       p->name, p->count, ms, p->items, rate,
+			       p->unit) > 0;
+	}
+
+	return ok;
+}
+
+int stats_write_trace (const char *path)
+{
+	FILE *out;
+	const struct span *s;
+	const char *sep = "";
+	const int pid = getpid ();
+	size_t i;
+	int ok;
+
+	if ((out = fopen (path, "w")) == NULL)
+		return 0;
+
+	ok = fprintf (out, "{\"traceEvents\":[") > 0;
+
+	for (i = 0, s = spans; ok && i < nspans; ++i, ++s, sep = ",")
+		ok = fprintf (out, "%s\n{\"name\":\"%s\",\"ph\":\"X\","
+			      "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":1}",
+			      sep, probe[s->id].name,
+			      (s->start - epoch) / 1e3, s->time / 1e3,
+			      pid) > 0;
+
+	ok &= fprintf (out, "\n]}\n") > 0;
+	ok &= fclose (out) == 0;
+
+	if (!ok)
+		remove (path);
+
+	return ok;
+}
@@ -11,7 +11,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/alloc.h>
 #include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+#include <dakota/data/intern.h>
 #include <dakota/symbol.h>
 
 struct node {
@@ -37,7 +40,9 @@ static struct node *node_alloc (int type, int x, int y, size_t extra)
 {
 	struct node *o;
 
-	if ((o = malloc (offsetof (struct node, arc) + extra)) == NULL)
+	o = dakota_alloc (ALLOC_SYMBOL, offsetof (struct node, arc) + extra);
+
+	if (o == NULL)
 		return NULL;
 
 	o->next = NULL;
@@ -53,49 +58,73 @@ static void node_free (struct node *o)
 
 	for (; o != NULL; o = next) {
 		next = o->next;
-		free (o);
+		dakota_free (o);
 	}
 }
 
+/*
+ * Tile index entry: own tiles have zero serial, names resolved in parents
+ * (found or not) are cached with serial of the root at resolution time
+ */
+struct ref {
+	const char *name;	/* interned, NULL for empty slot */
+	struct symbol *tile;
+	size_t serial;
+};
+
 struct symbol {
 	struct symbol *parent;
-	char *name;
+	const char *name;	/* interned */
 	struct node *head, *last;
 
-	size_t ntiles;
+	size_t ntiles, maxtiles;
 	struct symbol **tile;
+
+	size_t serial;		/* tiles added to this tree, root only */
+	size_t nrefs, nslots;
+	struct ref *ref;	/* tile index */
 };
 
 struct symbol *symbol_alloc (struct symbol *parent, const char *name)
 {
 	struct symbol *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	if ((o = dakota_alloc (ALLOC_SYMBOL, sizeof (*o))) == NULL)
 		return NULL;
 
 	o->parent = parent;
 
-	if ((o->name = strdup (name)) == NULL)
+	if ((o->name = intern (name)) == NULL)
 		goto no_name;
 
 	o->last = o->head = NULL;
-	o->ntiles = 0;
+	o->ntiles = o->maxtiles = 0;
 	o->tile   = NULL;
+
+	o->serial = 1;
+	o->nrefs  = 0;
+	o->nslots = 0;
+	o->ref    = NULL;
 	return o;
 no_name:
-	free (o);
+	dakota_free (o);
 	return NULL;
 }
 
+static void symbol_free_entry (struct symbol **o)
+{
+	symbol_free (*o);
+}
+
 void symbol_free (struct symbol *o)
 {
 	if (o == NULL)
 		return;
 
-	array_free (o->tile, o->ntiles, symbol_free);
+	array_free (o->tile, o->ntiles, symbol_free_entry);
+	dakota_free (o->ref);
 	node_free (o->head);
-	free (o->name);
-	free (o);
+	dakota_free (o);
 }
 
 static struct node *
@@ -191,12 +220,119 @@ int symbol_add_blit (struct symbol *o, int x, int y, int dir, const char *name)
 	return 1;
 }
 
+static struct symbol *symbol_root (struct symbol *o)
+{
+	for (; o->parent != NULL; o = o->parent) {}
+
+	return o;
+}
+
+/*
+ * Tile index: open addressing hash of interned names with linear probing,
+ * kept at most half full. Added tile may shadow names cached in subtree,
+ * thus cached entry is valid only while its serial matches the serial of
+ * the root.
+ */
+static struct ref *symbol_slot (const struct symbol *o, const char *name)
+{
+	const size_t mask = o->nslots - 1;
+	size_t i;
+
+	for (
+		i = hash_pointer (name) & mask;
+		o->ref[i].name != NULL && o->ref[i].name != name;
+		i = (i + 1) & mask
+	)
+		/* probe next */;
+
+	return o->ref + i;
+}
+
+static void symbol_drop_index (struct symbol *o)
+{
+	dakota_free (o->ref);
+
+	o->nrefs  = 0;
+	o->nslots = 0;
+	o->ref    = NULL;
+}
+
+/*
+ * Rebuild index to hold count entries, keep own tiles and cached entries
+ * which are still valid
+ */
+static int symbol_reindex (struct symbol *o, size_t count, size_t serial)
+{
+	struct ref *old = o->ref, *r;
+	const size_t nold = o->nslots;
+	size_t nslots, i;
+
+	for (nslots = 16; nslots < count * 4; nslots *= 2) {}
+
+	if ((r = dakota_zalloc (ALLOC_SYMBOL, sizeof (r[0]) * nslots)) == NULL)
+		return 0;
+
+	o->nrefs  = 0;
+	o->nslots = nslots;
+	o->ref    = r;
+
+	if (old == NULL)
+		for (i = o->ntiles; i > 0; --i) {  /* first tile wins */
+			r = symbol_slot (o, o->tile[i - 1]->name);
+			o->nrefs += (r->name == NULL);
+
+			r->name   = o->tile[i - 1]->name;
+			r->tile   = o->tile[i - 1];
+			r->serial = 0;
+		}
+
+	for (i = 0; i < nold; ++i)
+		if (old[i].name != NULL &&
+		    (old[i].serial == 0 || old[i].serial == serial)) {
+			*symbol_slot (o, old[i].name) = old[i];
+			++o->nrefs;
+		}
+
+	dakota_free (old);
+	return 1;
+}
+
+/*
+ * Put entry into index, existing own tile entry is kept
+ */
+static int symbol_index (struct symbol *o, const char *name,
+			 struct symbol *tile, size_t serial, size_t root)
+{
+	struct ref *r;
+
+	if (o->ref == NULL)
+		return 0;
+
+	if ((r = symbol_slot (o, name))->name == NULL) {
+		if ((o->nrefs + 1) * 2 > o->nslots) {
+			if (!symbol_reindex (o, o->nrefs + 1, root))
+				return 0;
+
+			r = symbol_slot (o, name);
+		}
+
+		++o->nrefs;
+	}
+	else if (r->serial == 0)
+		return 1;
+
+	r->name   = name;
+	r->tile   = tile;
+	r->serial = serial;
+	return 1;
+}
+
 int symbol_add_tile (struct symbol *o, struct symbol *tile)
 {
 	const size_t ntiles = o->ntiles + 1;
-	struct symbol **p;
+	struct symbol **p, *root;
 
-	if ((p = array_resize (o->tile, ntiles)) == NULL)
+	if ((p = array_grow (o->tile, o->maxtiles, ntiles)) == NULL)
 		return 0;
 
 	tile->parent = o;
@@ -204,23 +340,61 @@ int symbol_add_tile (struct symbol *o, struct symbol *tile)
 
 	o->tile   = p;
 	o->ntiles = ntiles;
+
+	/* invalidate cached names, tile may be a former root itself */
+	root = symbol_root (o);
+	root->serial = (root->serial > tile->serial ? root->serial :
+						      tile->serial) + 1;
+
+	if (!symbol_index (o, tile->name, tile, 0, root->serial))
+		symbol_drop_index (o);  /* rebuild on next lookup */
+
 	return 1;
 }
 
-struct symbol *symbol_get_tile (struct symbol *o, const char *name)
+static struct symbol *symbol_find (struct symbol *o, const char *name)
 {
 	size_t i;
 
+	for (i = 0; i < o->ntiles; ++i)  /* no memory for index */
+		if (o->tile[i]->name == name)
+			return o->tile[i];
+
+	return NULL;
+}
+
+static struct symbol *
+symbol_resolve (struct symbol *o, const char *name, size_t serial)
+{
+	struct ref *r;
+	struct symbol *s;
+
 	if (o == NULL)
 		return NULL;
 
-	/* ToDo: create hash table to map symbol name to symbol index */
+	if (o->ref == NULL && !symbol_reindex (o, o->ntiles, serial))
+		return	(s = symbol_find (o, name)) != NULL ? s :
+			symbol_resolve (o->parent, name, serial);
 
-	for (i = 0; i < o->ntiles; ++i)
-		if (strcmp (o->tile[i]->name, name) == 0)
-			return o->tile[i];
+	r = symbol_slot (o, name);
+
+	if (r->name != NULL && (r->serial == 0 || r->serial == serial))
+		return r->tile;
+
+	s = symbol_resolve (o->parent, name, serial);
+	symbol_index (o, name, s, serial, serial);  /* memoize, even misses */
+	return s;
+}
+
+/*
+ * Names are interned, thus never interned name matches no tile
+ */
+struct symbol *symbol_get_tile (struct symbol *o, const char *name)
+{
+	if (o == NULL || (name = intern_lookup (name)) == NULL)
+		return NULL;
 
-	return symbol_get_tile (o->parent, name);
+	return symbol_resolve (o, name, symbol_root (o)->serial);
 }
 
 int symbol_walk (const struct symbol *o, symbol_fn *fn, void *cookie)
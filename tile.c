@@ -12,12 +12,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <dakota/alloc.h>
+#include <dakota/data/intern.h>
+#include <dakota/stats.h>
 #include <dakota/tile.h>
 
 struct tile {
 	struct cmdb *db;
-	char *type;
+	const char *type;	/* interned */
 	struct bitmap *map;
+	struct arena *arena;	/* storage owner, NULL for heap */
 };
 
 static int tile_add_bits (struct tile *o, const char *value, int invert)
@@ -28,22 +32,46 @@ static int tile_add_bits (struct tile *o, const char *value, int invert)
 	if (strcmp (value, "-") == 0)
 		return 1;
 
-	bits = chip_bits_parse (value);
+	bits = chip_bits_parse (value, o->arena);
 
 	if (invert)
 		chip_bits_invert (bits);
 
 	ok = bitmap_add_bits (o->map, bits);
-	free (bits);
+
+	if (o->arena == NULL)
+		free (bits);
+
 	return ok;
 }
 
+/*
+ * Size bitmap to cover all raw bits first, thus it is allocated in its
+ * final shape and is never resized while raw bits are added
+ */
 static int tile_init (struct tile *o)
 {
+	const uint64_t span = stats_begin ();
 	const char *bits;
+	size_t width = 0, height = 0;
+	int ok = 0;
 
 	if (!cmdb_level (o->db, "tile :", o->type, NULL))
-		return 0;
+		goto out;
+
+	for (
+		bits = cmdb_first (o->db, "raw");
+		bits != NULL;
+		bits = cmdb_next (o->db, "raw", bits)
+	)
+		chip_bits_extent (bits, &width, &height);
+
+	if ((o->map = bitmap_alloc ()) == NULL)
+		goto out;
+
+	if (width > 0 && height > 0 &&
+	    !bitmap_resize (o->map, width - 1, height - 1))
+		goto no_bits;
 
 	for (
 		bits = cmdb_first (o->db, "raw");
@@ -51,47 +79,84 @@ static int tile_init (struct tile *o)
 		bits = cmdb_next (o->db, "raw", bits)
 	)
 		if (!tile_add_bits (o, bits, 0))
-			return 0;
+			goto no_bits;
 
-	return 1;
+	ok = 1;
+	goto out;
+no_bits:
+	bitmap_free (o->map);
+out:
+	stats_end (STATS_TILE, span, 1);
+	return ok;
 }
 
 struct tile *tile_alloc (struct cmdb *db, const char *type)
 {
 	struct tile *o;
 
-	if ((o = malloc (sizeof (*o))) == NULL)
+	if ((o = dakota_alloc (ALLOC_TILE, sizeof (*o))) == NULL)
 		return NULL;
 
-	o->db = db;
-
-	if ((o->type = strdup (type)) == NULL)
-		goto no_type;
+	o->db    = db;
+	o->arena = NULL;
 
-	if ((o->map = bitmap_alloc ()) == NULL)
-		goto no_map;
-
-	if (!tile_init (o))
+	if ((o->type = intern (type)) == NULL || !tile_init (o))
 		goto no_init;
 
 	return o;
 no_init:
-	bitmap_free (o->map);
+	dakota_free (o);
+	return NULL;
+}
+
+static
+struct tile *tile_clone_arena (const struct tile *from, struct arena *a)
+{
+	struct tile *o;
+
+	if ((o = arena_alloc (a, sizeof (*o))) == NULL)
+		return NULL;
+
+	o->db    = from->db;
+	o->type  = from->type;
+	o->arena = a;
+
+	if ((o->map = bitmap_clone (from->map, a)) == NULL)
+		return NULL;
+
+	return o;
+}
+
+struct tile *tile_clone (const struct tile *from, struct arena *arena)
+{
+	struct tile *o;
+
+	if (arena != NULL)
+		return tile_clone_arena (from, arena);
+
+	if ((o = dakota_alloc (ALLOC_TILE, sizeof (*o))) == NULL)
+		return NULL;
+
+	o->db    = from->db;
+	o->type  = from->type;
+	o->arena = NULL;
+
+	if ((o->map = bitmap_clone (from->map, NULL)) == NULL)
+		goto no_map;
+
+	return o;
 no_map:
-	free (o->type);
-no_type:
-	free (o);
+	dakota_free (o);
 	return NULL;
 }
 
 void tile_free (struct tile *o)
 {
-	if (o == NULL)
+	if (o == NULL || o->arena != NULL)
 		return;
 
 	bitmap_free (o->map);
-	free (o->type);
-	free (o);
+	dakota_free (o);
 }
 
 int tile_set_raw (struct tile *o, const unsigned *bits)
@@ -101,13 +166,21 @@ int tile_set_raw (struct tile *o, const unsigned *bits)
 
 int tile_set_mux (struct tile *o, const char *name, const char *source)
 {
+	uint64_t span;
+
 	if (strcmp (source, "_NONE_") == 0)
 		return 1;
 
+	span = stats_begin ();
+
 	if (!cmdb_level (o->db, "tile :", o->type, "mux :", name, NULL))
-		return 0;
+		source = NULL;
+	else
+		source = cmdb_first (o->db, source);
+
+	stats_end (STATS_LOOKUP, span, 1);
 
-	if ((source = cmdb_first (o->db, source)) == NULL) {
+	if (source == NULL) {
 		errno = ENOENT;
 		return 0;
 	}
@@ -120,6 +193,7 @@ int tile_set_word (struct tile *o, const char *name, const char *value)
 	size_t n = strlen (value), i;
 	char key[16];
 	const char *bits;
+	uint64_t span;
 
 	if (strcmp (value, "_NONE_") == 0)
 		return 1;
@@ -130,7 +204,11 @@ int tile_set_word (struct tile *o, const char *name, const char *value)
 	for (i = 0; i < n; ++i) {
 		snprintf (key, sizeof (key), "%zu", i);
 
-		if ((bits = cmdb_first (o->db, key)) == NULL) {
+		span = stats_begin ();
+		bits = cmdb_first (o->db, key);
+		stats_end (STATS_LOOKUP, span, 1);
+
+		if (bits == NULL) {
 			errno = ENOENT;
 			return 0;
 		}
@@ -144,13 +222,21 @@ int tile_set_word (struct tile *o, const char *name, const char *value)
 
 int tile_set_enum (struct tile *o, const char *name, const char *value)
 {
+	uint64_t span;
+
 	if (strcmp (value, "_NONE_") == 0)
 		return 1;
 
+	span = stats_begin ();
+
 	if (!cmdb_level (o->db, "tile :", o->type, "enum :", name, NULL))
-		return 0;
+		value = NULL;
+	else
+		value = cmdb_first (o->db, value);
+
+	stats_end (STATS_LOOKUP, span, 1);
 
-	if ((value = cmdb_first (o->db, value)) == NULL) {
+	if (value == NULL) {
 		errno = ENOENT;
 		return 0;
 	}
@@ -158,6 +244,11 @@ int tile_set_enum (struct tile *o, const char *name, const char *value)
 	return tile_add_bits (o, value, 0);
 }
 
+const char *tile_get_type (const struct tile *o)
+{
+	return o->type;
+}
+
 const struct bitmap *tile_get_bits (const struct tile *o)
 {
 	return o->map;
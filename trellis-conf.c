@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <dakota/chip-bits.h>
+#include <dakota/stats.h>
 
 #include "trellis-conf.h"
 
@@ -40,11 +41,15 @@ static int next_entry (FILE *in)
 	return (la != EOF);
 }
 
-static int next_record (FILE *in)
+static int next_record (struct chip_conf *o, FILE *in)
 {
 	int la = next_ns (in);
 
-	return (la != EOF && la != '.');
+	if (la == EOF || la == '.')
+		return 0;
+
+	++o->records;
+	return 1;
 }
 
 static int match (const char *a, const char *b)
@@ -123,7 +128,7 @@ static int read_mux_conf (struct chip_conf *o, FILE *in)
 	unsigned *bits;
 	int ok = 1;
 
-	while (ok && next_record (in)) {
+	while (ok && next_record (o, in)) {
 		if (fscanf (in, "%ms", &source) != 1)
 			return chip_error (o, "source name required");
 
@@ -159,7 +164,7 @@ static int read_word_conf (struct chip_conf *o, FILE *in)
 	unsigned *bits;
 	int ok = 1;
 
-	while (ok && next_record (in)) {
+	while (ok && next_record (o, in)) {
 		if ((bits = chip_bits_read (in)) == NULL && errno != 0)
 			return chip_error (o, "chip bits required");
 
@@ -190,7 +195,7 @@ static int read_enum_conf (struct chip_conf *o, FILE *in)
 	unsigned *bits;
 	int ok = 1;
 
-	while (ok && next_record (in)) {
+	while (ok && next_record (o, in)) {
 		if (fscanf (in, "%ms", &value) != 1)
 			return chip_error (o, "value name required");
 
@@ -227,7 +232,7 @@ static int read_tile_conf (struct chip_conf *o, FILE *in)
 	char type[16];
 	int ok = 1;
 
-	while (ok && next_record (in) && fscanf (in, "%15s", type) == 1)
+	while (ok && next_record (o, in) && fscanf (in, "%15s", type) == 1)
 		ok = match (type, "arc:")     ? read_arrow   (o, in, 0) :
 		     match (type, "word:")    ? read_word    (o, in, 0) :
 		     match (type, "enum:")    ? read_enum    (o, in, 0) :
@@ -281,7 +286,7 @@ static int read_bram (struct chip_conf *o, FILE *in)
 	ok = o->action->on_bram (o->cookie, name);
 	free (name);
 
-	while (ok && next_record (in)) {
+	while (ok && next_record (o, in)) {
 		if (fscanf (in, "%x", &value) != 1)
 			return chip_error (o, "hex bram value required");
 
@@ -293,10 +298,18 @@ static int read_bram (struct chip_conf *o, FILE *in)
 
 int trellis_read_conf (struct chip_conf *o, FILE *in)
 {
+	const uint64_t span = stats_begin ();
 	char verb[16];
+	size_t count;
 	int ok = 1;
 
-	while (ok && next_entry (in) && fscanf (in, "%15s", verb) == 1)
+	o->records = 0;
+
+	for (
+		count = 0;
+		ok && next_entry (in) && fscanf (in, "%15s", verb) == 1;
+		++count
+	)
 		ok = match (verb, ".device")      ? read_device     (o, in)    :
 		     match (verb, ".comment")     ? read_comment    (o, in)    :
 		     match (verb, ".sysconfig")   ? read_sysconfig  (o, in)    :
@@ -310,5 +323,8 @@ int trellis_read_conf (struct chip_conf *o, FILE *in)
 		     match (verb, ".bram_init")   ? read_bram       (o, in)    :
 		     chip_error (o, "unknown verb '%s'", verb);
 
+	/* span covers actions as well, they are measured by own probes */
+	stats_end (STATS_READ, span, count + o->records);
+
 	return ferror (in) ? chip_error (o, NULL) : ok;
 }
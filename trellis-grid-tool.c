@@ -81,7 +81,7 @@ int main (int argc, char *argv[])
 
 	json_object_put(root);
 
-	if (!cmdb_close (db))
+	if (!dakota_close (db))
 		errx (1, "cannot commit to database");
 
 	return 0;
@@ -6,223 +6,260 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <err.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#include <cmdb.h>
-#include <dakota/cache.h>
-#include <dakota/chip.h>
-
-#include "trellis-conf.h"
-
-struct ctx {
-	struct chip_conf *conf;
-	const char *family;
-	struct cmdb *tiles, *grid;
-	struct chip *chip;
-};
-
-static int on_device (void *cookie, const char *name)
-{
-	struct ctx *o = cookie;
-
-	if (o->grid != NULL)
-		return chip_error (o->conf, "device defined already");
-
-	if ((o->grid = dakota_open_grid (o->family, name, "r")) == NULL)
-		return chip_error (o->conf, "cannot open device database");
+#include <sys/wait.h>
+#include <unistd.h>
 
-	if (!chip_add_grid (o->chip, o->grid))
-		return chip_error (o->conf, "cannot assign device to chip");
-
-	return 1;
-}
+#include <dakota/alloc.h>
+#include <dakota/cache.h>
+#include <dakota/stats.h>
+#include <dakota/string.h>
 
-static int on_comment (void *cookie, const char *value)
-{
-	return 1;
-}
+#include "trellis-map.h"
 
-static int on_sysconfig (void *cookie, const char *name, const char *value)
-{
-	return 1;
-}
+static int show_stats;
+static const char *trace;
 
-static int on_tile (void *cookie, const char *name)
+/*
+ * Print statistics and memory summary and save trace, batch worker adds
+ * its number to the trace file name
+ */
+static int report (int job)
 {
-	struct ctx *o = cookie;
-	char *type;
+	char *path;
+	int ok = 1;
 
-	if (o->grid == NULL)
-		return chip_error (o->conf, "device does not defined");
+	if (show_stats) {
+		ok &= stats_report (stderr);
+		ok &= dakota_alloc_report (stderr);
+	}
 
-	if ((type = strchr (name, ':')) == NULL)
-		return chip_error (o->conf, "cannot parse tile name");
+	if (trace == NULL)
+		return ok;
 
-	++type;
+	if (job < 0)
+		path = make_string ("%s", trace);
+	else
+		path = make_string ("%s.%d", trace, job);
 
-	if (!chip_add_tile (o->chip, name, type))
-		return chip_error (o->conf, "cannot add tile %s", name);
+	if (path == NULL || !stats_write_trace (path)) {
+		warn ("cannot write trace %s", path != NULL ? path : trace);
+		ok = 0;
+	}
 
-	return 1;
+	free (path);
+	return ok;
 }
 
-static int on_raw (void *cookie, unsigned bit)
+static int map_one (struct trellis_map *o, const char *in, const char *out)
 {
-	struct ctx *o = cookie;
-
-	if (!chip_set_raw (o->chip, &bit))
-		return chip_error (o->conf, "cannot apply raw");
+	if (trellis_map (o, in, out))
+		return 1;
 
-	return 1;
+	warnx ("%s: %s", in, trellis_map_error (o));
+	return 0;
 }
 
-static int on_arrow (void *cookie, const char *sink, const char *source)
+static int remap_one (struct trellis_map *o, const char *in, const char *out,
+		      const char *state)
 {
-	struct ctx *o = cookie;
-
-	if (!chip_set_mux (o->chip, sink, source))
-		return chip_error (o->conf, "cannot apply arrow");
+	if (trellis_remap (o, in, out, state))
+		return 1;
 
-	return 1;
+	warnx ("%s: %s", in, trellis_map_error (o));
+	return 0;
 }
 
-static int on_mux (void *cookie, const char *name)
+/*
+ * Batch list entry: design file and optional output file, by default
+ * output file name made from design one with .trellis suffix replaced
+ * by .pnm
+ */
+static int map_entry (struct trellis_map *o, char *line)
 {
-	struct ctx *o = cookie;
+	char *in, *out, *p;
+	size_t len;
+	int ok;
 
-	return chip_error (o->conf, "unexpected mux entry");
-}
+	if ((in = strtok (line, " \t\r\n")) == NULL || in[0] == '#')
+		return 1;
 
-static int on_mux_data (void *cookie, const char *source, unsigned *bits)
-{
-	struct ctx *o = cookie;
+	if ((out = strtok (NULL, " \t\r\n")) != NULL)
+		return map_one (o, in, out);
 
-	return chip_error (o->conf, "unexpected mux data entry");
-}
+	len = strlen (in);
 
-static int on_word (void *cookie, const char *name, const char *value)
-{
-	struct ctx *o = cookie;
+	if (len > 8 && strcmp (in + len - 8, ".trellis") == 0)
+		len -= 8;
 
-	if (!chip_set_word (o->chip, name, value))
-		return chip_error (o->conf, "cannot apply word");
+	if ((p = make_string ("%.*s.pnm", (int) len, in)) == NULL) {
+		warn ("%s", in);
+		return 0;
+	}
 
-	return 1;
+	ok = map_one (o, in, p);
+	free (p);
+	return ok;
 }
 
-static int on_word_data (void *cookie, unsigned *bits)
+/*
+ * Map every job-th design from the list starting with the given one
+ */
+static int map_list (struct trellis_map *o, const char *path, int job, int jobs)
 {
-	struct ctx *o = cookie;
-
-	return chip_error (o->conf, "unexpected word data entry");
+	FILE *list;
+	char *line = NULL;
+	size_t size = 0;
+	int i, ok = 1;
+
+	if ((list = fopen (path, "r")) == NULL) {
+		warn ("cannot open batch list %s", path);
+		return 0;
+	}
+
+	for (i = 0; getline (&line, &size, list) > 0; ++i)
+		if (i % jobs == job)
+			ok &= map_entry (o, line);
+
+	free (line);
+	fclose (list);
+	return ok;
 }
 
-static int on_enum (void *cookie, const char *name, const char *value)
+static struct trellis_map *map_open (const char *family)
 {
-	struct ctx *o = cookie;
+	struct trellis_map *o;
 
-	if (!chip_set_enum (o->chip, name, value))
-		return chip_error (o->conf, "cannot apply enum");
+	if ((o = trellis_map_alloc (family)) == NULL)
+		warnx ("cannot open database");
 
-	return 1;
+	return o;
 }
 
-static int on_enum_data (void *cookie, const char *key, unsigned *bits)
+/*
+ * Every worker opens databases after fork, thus workers do not share
+ * file positions of database handles, and maps its own part of the list
+ */
+static int map_worker (const char *family, const char *path, int job,
+		       int jobs)
 {
-	struct ctx *o = cookie;
-
-	return chip_error (o->conf, "unexpected enum data entry");
-}
+	struct trellis_map *o;
+	int ok;
 
-static int on_bram (void *cookie, const char *name)
-{
-	return 1;
-}
+	if ((o = map_open (family)) == NULL)
+		return 0;
 
-static int on_bram_data (void *cookie, unsigned value)
-{
-	return 1;
+	ok = map_list (o, path, job, jobs);
+	trellis_map_free (o);
+	return ok;
 }
 
-static int on_commit (void *cookie)
+static int map_batch (const char *family, const char *path, int jobs)
 {
-	struct ctx *o = cookie;
-
-	if (!chip_commit (o->chip))
-		chip_error (o->conf, "cannot commit changes");
-
-	return 1;
+	int job, status, ok = 1;
+	pid_t pid;
+
+	if (jobs == 1)
+		return map_worker (family, path, 0, 1);
+
+	for (job = 0; job < jobs; ++job) {
+		if ((pid = fork ()) < 0) {
+			warn ("cannot start worker");
+			ok = 0;
+			break;
+		}
+
+		if (pid == 0) {
+			ok = map_worker (family, path, job, jobs);
+			ok &= report (job);
+			exit (ok ? 0 : 1);
+		}
+	}
+
+	while (wait (&status) > 0)
+		ok &= WIFEXITED (status) && WEXITSTATUS (status) == 0;
+
+	return ok;
 }
 
-static const struct chip_action action = {
-	.on_device	= on_device,
-	.on_comment	= on_comment,
-	.on_sysconfig	= on_sysconfig,
-
-	.on_tile	= on_tile,
-
-	.on_raw		= on_raw,
-	.on_arrow	= on_arrow,
-
-	.on_mux		= on_mux,
-	.on_mux_data	= on_mux_data,
-
-	.on_word	= on_word,
-	.on_word_data	= on_word_data,
-
-	.on_enum	= on_enum,
-	.on_enum_data	= on_enum_data,
-
-	.on_bram	= on_bram,
-	.on_bram_data	= on_bram_data,
-
-	.on_commit	= on_commit,
+static const struct option opts[] = {
+	{ "base",	1, NULL, 'B' },
+	{ "batch",	1, NULL, 'b' },
+	{ "jobs",	1, NULL, 'j' },
+	{ "stats",	0, NULL, 's' },
+	{ "trace",	1, NULL, 't' },
+	{ NULL }
 };
 
-#include <err.h>
+static void usage (void)
+{
+	errx (0, "\n\t"
+		 "trellis-map [--stats] [--trace <trace.json>] [--base <state>] "
+		 "<family> <design.trellis> <out.pnm>\n\t"
+		 "trellis-map [--stats] [--trace <trace.json>] [-j <jobs>] "
+		 "--batch <list> <family>");
+}
 
 int main (int argc, char *argv[])
 {
-	struct chip_conf c;
-	struct ctx o;
-	FILE *in;
-	int ok;
-
-	if (argc != 4)
-		errx (0, "\n\t"
-			 "trellis-map <family> <design.trellis> <out.pnm>");
-
-	o.conf   = &c;
-	o.family = argv[1];
-	o.grid   = NULL;
-
-	if ((o.tiles = dakota_open_tiles (o.family, "r")) == NULL)
-		errx (1, "cannot open database");
-
-	if ((o.chip = chip_alloc (o.tiles, NULL)) == NULL)
-		err (1, "cannot create chip");
-
-	if ((in = fopen (argv[2], "r")) == NULL)
-		err (1, "cannot open design file %s", argv[2]);
-
-	c.action = &action;
-	c.cookie = &o;
-	c.error[0] = '\0';
-
-	ok = trellis_read_conf (&c, in);
-	fclose (in);
-
-	if (!ok)
-		errx (1, c.error);
-
-	if (!bitmap_export (chip_get_bits (o.chip), argv[3]))
-		err (1, "cannot export bitmap to %s", argv[3]);
-
-	cmdb_close (o.tiles);
-	cmdb_close (o.grid);
-	chip_free (o.chip);
-
-	return 0;
+	const char *base = NULL, *batch = NULL;
+	int c, jobs = 1, ok;
+	struct trellis_map *o;
+
+	while ((c = getopt_long (argc, argv, "B:b:j:st:", opts, NULL)) != -1)
+		switch (c) {
+		case 'B':
+			base = optarg;
+			break;
+		case 'b':
+			batch = optarg;
+			break;
+		case 'j':
+			if ((jobs = atoi (optarg)) < 1)
+				usage ();
+			break;
+		case 's':
+			show_stats = 1;
+			break;
+		case 't':
+			trace = optarg;
+			break;
+		default:
+			usage ();
+		}
+
+	argc -= optind;
+	argv += optind;
+
+	if (argc != (batch == NULL ? 3 : 1) || (base != NULL && batch != NULL))
+		usage ();
+
+	dakota_cache_prefetch (1);
+
+	if (show_stats || trace != NULL)
+		stats_enable (trace != NULL);
+
+	if (batch != NULL) {
+		ok = map_batch (argv[0], batch, jobs);
+
+		if (jobs == 1)  /* workers report by themselves */
+			ok &= report (-1);
+
+		return ok ? 0 : 1;
+	}
+
+	if ((o = map_open (argv[0])) == NULL)
+		return 1;
+
+	ok = base != NULL ? remap_one (o, argv[1], argv[2], base) :
+			    map_one (o, argv[1], argv[2]);
+
+	ok &= report (-1);
+	trellis_map_free (o);
+	return ok ? 0 : 1;
 }
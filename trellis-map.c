@@ -0,0 +1,916 @@
+/*
+ * Trellis Design Map
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cmdb.h>
+#include <dakota/cache.h>
+#include <dakota/chip.h>
+#include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+
+#include "trellis-conf.h"
+#include "trellis-map.h"
+#include "trellis-state.h"
+
+/*
+ * Design journal: records of tile blocks collected to be applied later
+ */
+enum event_type {
+	EVENT_TILE	= 0,
+	EVENT_RAW	= 1,
+	EVENT_ARROW	= 2,
+	EVENT_WORD	= 3,
+	EVENT_ENUM	= 4,
+};
+
+struct event {
+	int type;
+	unsigned bit;
+	char *a, *b;
+};
+
+struct block {
+	size_t first, count;	/* range of block events */
+	const char *key;	/* name of the first tile or NULL */
+	uint64_t hash;		/* hash of block events */
+
+	int dirty;		/* should be (re)applied */
+	size_t x, y, w, h;	/* rectangle touched by block */
+	struct bitmap *map;	/* block contents if applied */
+};
+
+struct journal {
+	size_t nevents, maxevents;
+	struct event *event;
+	size_t nblocks, maxblocks;
+	struct block *block;
+};
+
+struct trellis_map {
+	struct chip_conf conf;
+	char *family, *device;
+	struct cmdb *tiles, *grid;
+	struct chip *chip;
+
+	size_t ngrids;
+	struct cmdb **grids;	/* device databases opened so far */
+
+	struct journal journal;
+};
+
+static void journal_init (struct journal *o)
+{
+	o->nevents   = 0;
+	o->maxevents = 0;
+	o->event     = NULL;
+	o->nblocks   = 0;
+	o->maxblocks = 0;
+	o->block     = NULL;
+}
+
+static void journal_reset (struct journal *o)
+{
+	size_t i;
+
+	for (i = 0; i < o->nevents; ++i) {
+		free (o->event[i].a);
+		free (o->event[i].b);
+	}
+
+	for (i = 0; i < o->nblocks; ++i)
+		bitmap_free (o->block[i].map);
+
+	o->nevents = 0;
+	o->nblocks = 0;
+}
+
+static void journal_fini (struct journal *o)
+{
+	journal_reset (o);
+	array_free (o->event, o->nevents, NULL);
+	array_free (o->block, o->nblocks, NULL);
+}
+
+static char *dup_string (const char *s)
+{
+	return s == NULL ? NULL : strdup (s);
+}
+
+static int journal_add (struct journal *o, int type, unsigned bit,
+			const char *a, const char *b)
+{
+	size_t next = o->maxevents == 0 ? 256 : o->maxevents * 2;
+	struct event *p;
+
+	if (o->nevents == o->maxevents) {
+		if ((p = array_resize (o->event, next)) == NULL)
+			return 0;
+
+		o->event     = p;
+		o->maxevents = next;
+	}
+
+	p = o->event + o->nevents;
+
+	p->type = type;
+	p->bit  = bit;
+
+	if ((p->a = dup_string (a)) == NULL && a != NULL)
+		return 0;
+
+	if ((p->b = dup_string (b)) == NULL && b != NULL)
+		goto no_b;
+
+	++o->nevents;
+	return 1;
+no_b:
+	free (p->a);
+	return 0;
+}
+
+static uint64_t hash_event (uint64_t h, const struct event *e)
+{
+	h = hash_data (h, &e->type, sizeof (e->type));
+	h = hash_data (h, &e->bit,  sizeof (e->bit));
+	h = e->a == NULL ? hash_data (h, "", 1) : hash_string (h, e->a);
+	h = e->b == NULL ? hash_data (h, "", 1) : hash_string (h, e->b);
+
+	return h;
+}
+
+/*
+ * Close current block: all events since the end of previous block
+ */
+static int journal_commit (struct journal *o)
+{
+	size_t next = o->maxblocks == 0 ? 64 : o->maxblocks * 2;
+	struct block *p;
+	size_t i;
+
+	if (o->nblocks == o->maxblocks) {
+		if ((p = array_resize (o->block, next)) == NULL)
+			return 0;
+
+		o->block     = p;
+		o->maxblocks = next;
+	}
+
+	p = o->block + o->nblocks;
+
+	p->first = o->nblocks == 0 ? 0 : p[-1].first + p[-1].count;
+	p->count = o->nevents - p->first;
+	p->key   = NULL;
+	p->hash  = HASH_INIT;
+	p->dirty = 1;
+	p->x = p->y = p->w = p->h = 0;
+	p->map   = NULL;
+
+	for (i = p->first; i < o->nevents; ++i) {
+		if (p->key == NULL && o->event[i].type == EVENT_TILE)
+			p->key = o->event[i].a;
+
+		p->hash = hash_event (p->hash, o->event + i);
+	}
+
+	++o->nblocks;
+	return 1;
+}
+
+static int trellis_map_add_grid (struct trellis_map *o, struct cmdb *grid)
+{
+	const size_t ngrids = o->ngrids + 1;
+	struct cmdb **p;
+	size_t i;
+
+	for (i = 0; i < o->ngrids; ++i)
+		if (o->grids[i] == grid) {
+			dakota_close (grid);  /* drop extra reference */
+			return 1;
+		}
+
+	if ((p = array_resize (o->grids, ngrids)) == NULL)
+		return 0;
+
+	p[o->ngrids] = grid;
+
+	o->grids  = p;
+	o->ngrids = ngrids;
+	return 1;
+}
+
+static int on_device (void *cookie, const char *name)
+{
+	struct trellis_map *o = cookie;
+	struct cmdb *grid;
+
+	if (o->grid != NULL)
+		return chip_error (&o->conf, "device defined already");
+
+	if ((grid = dakota_open_grid (o->family, name, "r")) == NULL)
+		return chip_error (&o->conf, "cannot open device database");
+
+	free (o->device);
+
+	if ((o->device = strdup (name)) == NULL) {
+		dakota_close (grid);
+		return chip_error (&o->conf, NULL);
+	}
+
+	if (!trellis_map_add_grid (o, grid)) {
+		dakota_close (grid);
+		return chip_error (&o->conf, NULL);
+	}
+
+	o->grid = grid;
+
+	if (!chip_add_grid (o->chip, o->grid))
+		return chip_error (&o->conf, "cannot assign device to chip");
+
+	return 1;
+}
+
+static int on_comment (void *cookie, const char *value)
+{
+	return 1;
+}
+
+static int on_sysconfig (void *cookie, const char *name, const char *value)
+{
+	return 1;
+}
+
+static int on_tile (void *cookie, const char *name)
+{
+	struct trellis_map *o = cookie;
+	char *type;
+
+	if (o->grid == NULL)
+		return chip_error (&o->conf, "device does not defined");
+
+	if ((type = strchr (name, ':')) == NULL)
+		return chip_error (&o->conf, "cannot parse tile name");
+
+	++type;
+
+	if (!chip_add_tile (o->chip, name, type))
+		return chip_error (&o->conf, "cannot add tile %s", name);
+
+	return 1;
+}
+
+static int on_raw (void *cookie, unsigned bit)
+{
+	struct trellis_map *o = cookie;
+
+	if (!chip_set_raw (o->chip, &bit))
+		return chip_error (&o->conf, "cannot apply raw");
+
+	return 1;
+}
+
+static int on_arrow (void *cookie, const char *sink, const char *source)
+{
+	struct trellis_map *o = cookie;
+
+	if (!chip_set_mux (o->chip, sink, source))
+		return chip_error (&o->conf, "cannot apply arrow");
+
+	return 1;
+}
+
+static int on_mux (void *cookie, const char *name)
+{
+	struct trellis_map *o = cookie;
+
+	return chip_error (&o->conf, "unexpected mux entry");
+}
+
+static int on_mux_data (void *cookie, const char *source, unsigned *bits)
+{
+	struct trellis_map *o = cookie;
+
+	return chip_error (&o->conf, "unexpected mux data entry");
+}
+
+static int on_word (void *cookie, const char *name, const char *value)
+{
+	struct trellis_map *o = cookie;
+
+	if (!chip_set_word (o->chip, name, value))
+		return chip_error (&o->conf, "cannot apply word");
+
+	return 1;
+}
+
+static int on_word_data (void *cookie, unsigned *bits)
+{
+	struct trellis_map *o = cookie;
+
+	return chip_error (&o->conf, "unexpected word data entry");
+}
+
+static int on_enum (void *cookie, const char *name, const char *value)
+{
+	struct trellis_map *o = cookie;
+
+	if (!chip_set_enum (o->chip, name, value))
+		return chip_error (&o->conf, "cannot apply enum");
+
+	return 1;
+}
+
+static int on_enum_data (void *cookie, const char *key, unsigned *bits)
+{
+	struct trellis_map *o = cookie;
+
+	return chip_error (&o->conf, "unexpected enum data entry");
+}
+
+static int on_bram (void *cookie, const char *name)
+{
+	return 1;
+}
+
+static int on_bram_data (void *cookie, unsigned value)
+{
+	return 1;
+}
+
+static int on_commit (void *cookie)
+{
+	struct trellis_map *o = cookie;
+
+	if (!chip_commit (o->chip))
+		chip_error (&o->conf, "cannot commit changes");
+
+	return 1;
+}
+
+static const struct chip_action action = {
+	.on_device	= on_device,
+	.on_comment	= on_comment,
+	.on_sysconfig	= on_sysconfig,
+
+	.on_tile	= on_tile,
+
+	.on_raw		= on_raw,
+	.on_arrow	= on_arrow,
+
+	.on_mux		= on_mux,
+	.on_mux_data	= on_mux_data,
+
+	.on_word	= on_word,
+	.on_word_data	= on_word_data,
+
+	.on_enum	= on_enum,
+	.on_enum_data	= on_enum_data,
+
+	.on_bram	= on_bram,
+	.on_bram_data	= on_bram_data,
+
+	.on_commit	= on_commit,
+};
+
+/*
+ * Recording actions: collect tile blocks into journal
+ */
+static int on_record_tile (void *cookie, const char *name)
+{
+	struct trellis_map *o = cookie;
+
+	if (o->grid == NULL)
+		return chip_error (&o->conf, "device does not defined");
+
+	if (!journal_add (&o->journal, EVENT_TILE, 0, name, NULL))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static int on_record_raw (void *cookie, unsigned bit)
+{
+	struct trellis_map *o = cookie;
+
+	if (!journal_add (&o->journal, EVENT_RAW, bit, NULL, NULL))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static int on_record_arrow (void *cookie, const char *sink, const char *source)
+{
+	struct trellis_map *o = cookie;
+
+	if (!journal_add (&o->journal, EVENT_ARROW, 0, sink, source))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static int on_record_word (void *cookie, const char *name, const char *value)
+{
+	struct trellis_map *o = cookie;
+
+	if (!journal_add (&o->journal, EVENT_WORD, 0, name, value))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static int on_record_enum (void *cookie, const char *name, const char *value)
+{
+	struct trellis_map *o = cookie;
+
+	if (!journal_add (&o->journal, EVENT_ENUM, 0, name, value))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static int on_record_commit (void *cookie)
+{
+	struct trellis_map *o = cookie;
+
+	if (!journal_commit (&o->journal))
+		return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+static const struct chip_action record_action = {
+	.on_device	= on_device,
+	.on_comment	= on_comment,
+	.on_sysconfig	= on_sysconfig,
+
+	.on_tile	= on_record_tile,
+
+	.on_raw		= on_record_raw,
+	.on_arrow	= on_record_arrow,
+
+	.on_mux		= on_mux,
+	.on_mux_data	= on_mux_data,
+
+	.on_word	= on_record_word,
+	.on_word_data	= on_word_data,
+
+	.on_enum	= on_record_enum,
+	.on_enum_data	= on_enum_data,
+
+	.on_bram	= on_bram,
+	.on_bram_data	= on_bram_data,
+
+	.on_commit	= on_record_commit,
+};
+
+struct trellis_map *trellis_map_alloc (const char *family)
+{
+	struct trellis_map *o;
+
+	if ((o = malloc (sizeof (*o))) == NULL)
+		return NULL;
+
+	o->conf.action   = &action;
+	o->conf.cookie   = o;
+	o->conf.error[0] = '\0';
+
+	if ((o->family = strdup (family)) == NULL)
+		goto no_family;
+
+	if ((o->tiles = dakota_open_tiles (family, "r")) == NULL)
+		goto no_tiles;
+
+	if ((o->chip = chip_alloc (o->tiles, NULL)) == NULL)
+		goto no_chip;
+
+	o->device = NULL;
+	o->grid   = NULL;
+	o->ngrids = 0;
+	o->grids  = NULL;
+
+	journal_init (&o->journal);
+	return o;
+no_chip:
+	dakota_close (o->tiles);
+no_tiles:
+	free (o->family);
+no_family:
+	free (o);
+	return NULL;
+}
+
+void trellis_map_free (struct trellis_map *o)
+{
+	size_t i;
+
+	if (o == NULL)
+		return;
+
+	journal_fini (&o->journal);
+	chip_free (o->chip);
+
+	for (i = 0; i < o->ngrids; ++i)
+		dakota_close (o->grids[i]);
+
+	array_free (o->grids, o->ngrids, NULL);
+	dakota_close (o->tiles);
+	free (o->family);
+	free (o->device);
+	free (o);
+}
+
+static void trellis_map_reset (struct trellis_map *o)
+{
+	chip_reset (o->chip);
+	journal_reset (&o->journal);
+
+	free (o->device);
+
+	o->device = NULL;
+	o->grid   = NULL;
+	o->conf.error[0] = '\0';
+}
+
+int trellis_map (struct trellis_map *o, const char *in, const char *out)
+{
+	FILE *f;
+	int ok;
+
+	trellis_map_reset (o);
+
+	if ((f = fopen (in, "r")) == NULL)
+		return chip_error (&o->conf, "cannot open design file %s: %s",
+				   in, strerror (errno));
+
+	ok = trellis_read_conf (&o->conf, f);
+	fclose (f);
+
+	if (!ok)
+		return 0;
+
+	if (!bitmap_export (chip_get_bits (o->chip), out))
+		return chip_error (&o->conf, "cannot export bitmap to %s: %s",
+				   out, strerror (errno));
+
+	return 1;
+}
+
+/*
+ * Incremental remap
+ */
+static int block_apply (struct trellis_map *o, struct block *b)
+{
+	const struct event *e = o->journal.event + b->first;
+	size_t i;
+	int ok = 1;
+
+	for (i = 0; ok && i < b->count; ++i, ++e)
+		switch (e->type) {
+		case EVENT_TILE:  ok = on_tile  (o, e->a);		break;
+		case EVENT_RAW:   ok = on_raw   (o, e->bit);		break;
+		case EVENT_ARROW: ok = on_arrow (o, e->a, e->b);	break;
+		case EVENT_WORD:  ok = on_word  (o, e->a, e->b);	break;
+		case EVENT_ENUM:  ok = on_enum  (o, e->a, e->b);	break;
+		}
+
+	if (!ok)
+		return 0;
+
+	if ((b->map = chip_commit_apart (o->chip, &b->x, &b->y)) == NULL)
+		return chip_error (&o->conf, "cannot commit changes");
+
+	b->w = b->map->width;
+	b->h = b->map->height;
+	b->dirty = 1;
+	return 1;
+}
+
+struct rect {
+	size_t x, y, w, h;
+};
+
+struct region {
+	size_t count, max;
+	struct rect *rect;
+};
+
+static int region_add (struct region *o, size_t x, size_t y, size_t w, size_t h)
+{
+	size_t next = o->max == 0 ? 16 : o->max * 2;
+	struct rect *p;
+
+	if (w == 0 || h == 0)
+		return 1;
+
+	if (o->count == o->max) {
+		if ((p = array_resize (o->rect, next)) == NULL)
+			return 0;
+
+		o->rect = p;
+		o->max  = next;
+	}
+
+	p = o->rect + o->count++;
+
+	p->x = x;
+	p->y = y;
+	p->w = w;
+	p->h = h;
+	return 1;
+}
+
+static int region_touch (const struct region *o, const struct block *b)
+{
+	const struct rect *r;
+	size_t i;
+
+	if (b->w == 0 || b->h == 0)
+		return 0;
+
+	for (i = 0, r = o->rect; i < o->count; ++i, ++r)
+		if (b->x < r->x + r->w && r->x < b->x + b->w &&
+		    b->y < r->y + r->h && r->y < b->y + b->h)
+			return 1;
+
+	return 0;
+}
+
+/*
+ * Select blocks to apply: changed blocks and blocks overlapped with
+ * changed or removed ones. Returns -1 on error, 0 if the whole image
+ * should be rebuilt, 1 if image can be patched.
+ */
+static int trellis_map_diff (struct trellis_map *o, struct trellis_state *s,
+			     struct region *r, const struct bitmap *image)
+{
+	struct journal *j = &o->journal;
+	struct block *b;
+	const struct trellis_block *old;
+	char *seen;
+	size_t i, k, w, h;
+	int more;
+
+	if ((seen = calloc (s->nblocks + 1, 1)) == NULL)
+		return -1;
+
+	for (i = 0, b = j->block; i < j->nblocks; ++i, ++b) {
+		if (b->key == NULL)
+			continue;  /* no tiles, always apply */
+
+		if ((k = trellis_state_find (s, b->key)) == TS_UNKNOWN)
+			continue;
+
+		if (seen[k])
+			goto full;  /* duplicate tile block */
+
+		seen[k] = 1;
+		old = s->block + k;
+
+		if (old->hash == b->hash) {
+			b->dirty = 0;
+			b->x = old->x, b->y = old->y, b->w = old->w, b->h = old->h;
+		}
+		else
+		if (!region_add (r, old->x, old->y, old->w, old->h))
+			goto error;
+	}
+
+	for (k = 0, old = s->block; k < s->nblocks; ++k, ++old)
+		if (!seen[k] && !region_add (r, old->x, old->y, old->w, old->h))
+			goto error;
+
+	for (i = 0, b = j->block; i < j->nblocks; ++i, ++b)
+		if (b->dirty && (!block_apply (o, b) ||
+				 !region_add (r, b->x, b->y, b->w, b->h)))
+			goto error;
+
+	do {
+		for (i = 0, more = 0, b = j->block; i < j->nblocks; ++i, ++b)
+			if (!b->dirty && region_touch (r, b)) {
+				if (!block_apply (o, b) ||
+				    !region_add (r, b->x, b->y, b->w, b->h))
+					goto error;
+
+				more = 1;
+			}
+	}
+	while (more);
+
+	/* image never shrinks, rebuild it if some edge block was removed */
+
+	for (i = 0, w = h = 0, b = j->block; i < j->nblocks; ++i, ++b)
+		if (b->w > 0 && b->h > 0) {
+			w = b->x + b->w > w ? b->x + b->w : w;
+			h = b->y + b->h > h ? b->y + b->h : h;
+		}
+
+	if (w < image->width || h < image->height)
+		goto full;
+
+	free (seen);
+	return 1;
+full:
+	free (seen);
+	return 0;
+error:
+	free (seen);
+	return -1;
+}
+
+static int trellis_map_rebuild (struct trellis_map *o, struct bitmap *image)
+{
+	struct journal *j = &o->journal;
+	size_t i;
+
+	bitmap_clear (image);
+
+	for (i = 0; i < j->nblocks; ++i)
+		if (j->block[i].map == NULL && !block_apply (o, j->block + i))
+			return 0;
+
+	return 1;
+}
+
+static int trellis_map_patch (struct trellis_map *o, struct bitmap *image,
+			      const struct region *r)
+{
+	struct journal *j = &o->journal;
+	const struct rect *p;
+	const struct block *b;
+	size_t i;
+
+	for (i = 0, p = r->rect; i < r->count; ++i, ++p)
+		bitmap_erase (image, p->x, p->y, p->w, p->h);
+
+	for (i = 0, b = j->block; i < j->nblocks; ++i, ++b)
+		if (b->dirty && !bitmap_blit (image, b->x, b->y, b->map))
+			return chip_error (&o->conf, NULL);
+
+	return 1;
+}
+
+/*
+ * Content hash of image file as written, to notice image replaced or
+ * modified by others
+ */
+static int file_hash (const char *path, uint64_t *hash)
+{
+	unsigned char buf[65536];
+	FILE *f;
+	size_t len;
+	uint64_t h = HASH_INIT;
+	int ok;
+
+	if ((f = fopen (path, "rb")) == NULL)
+		return 0;
+
+	while ((len = fread (buf, 1, sizeof (buf), f)) > 0)
+		h = hash_data (h, buf, len);
+
+	ok = !ferror (f);
+	fclose (f);
+
+	*hash = h;
+	return ok;
+}
+
+static int trellis_map_save (struct trellis_map *o, const char *path,
+			     const char *out, const struct bitmap *image)
+{
+	const char *device = o->device == NULL ? "-" : o->device;
+	struct trellis_state s;
+	const struct block *b;
+	size_t i;
+	int ok;
+
+	trellis_state_init (&s);
+
+	ok = trellis_state_set (&s, o->family, device, image->width,
+				image->height) &&
+	     file_hash (out, &s.image);
+
+	for (i = 0, b = o->journal.block; ok && i < o->journal.nblocks; ++i, ++b)
+		if (b->key != NULL)
+			ok = trellis_state_add (&s, b->key, b->hash,
+						b->x, b->y, b->w, b->h);
+
+	ok = ok && trellis_state_write (&s, path);
+	trellis_state_fini (&s);
+
+	return ok ? 1 : chip_error (&o->conf, "cannot write map state to "
+				    "%s: %s", path, strerror (errno));
+}
+
+/*
+ * Load previous state and image, returns NULL if they do not match
+ * current design or image file is not the one we wrote
+ */
+static struct bitmap *
+trellis_map_load (struct trellis_map *o, struct trellis_state *s,
+		  const char *out, const char *state)
+{
+	const char *device = o->device == NULL ? "-" : o->device;
+	struct bitmap *image;
+	uint64_t hash;
+
+	if (!trellis_state_read (s, state) ||
+	    strcmp (s->family, o->family) != 0 ||
+	    strcmp (s->device, device) != 0)
+		return NULL;
+
+	if (!file_hash (out, &hash) || hash != s->image)
+		return NULL;
+
+	if ((image = bitmap_import (out)) == NULL)
+		return NULL;
+
+	if (image->width == s->width && image->height == s->height)
+		return image;
+
+	bitmap_free (image);
+	return NULL;
+}
+
+int trellis_remap (struct trellis_map *o, const char *in, const char *out,
+		   const char *state)
+{
+	struct trellis_state s;
+	struct region r = {0, 0, NULL};
+	struct bitmap *image;
+	FILE *f;
+	int ok;
+
+	trellis_map_reset (o);
+
+	if ((f = fopen (in, "r")) == NULL)
+		return chip_error (&o->conf, "cannot open design file %s: %s",
+				   in, strerror (errno));
+
+	o->conf.action = &record_action;
+	ok = trellis_read_conf (&o->conf, f);
+	o->conf.action = &action;
+	fclose (f);
+
+	if (!ok)
+		return 0;
+
+	trellis_state_init (&s);
+
+	if ((image = trellis_map_load (o, &s, out, state)) != NULL)
+		ok = trellis_map_diff (o, &s, &r, image);
+	else
+	if ((image = bitmap_alloc ()) == NULL)
+		goto no_image;
+	else
+		ok = 0;
+
+	if (ok < 0)
+		goto error;
+
+	if (ok)
+		ok = trellis_map_patch (o, image, &r);
+	else
+		ok = trellis_map_rebuild (o, image) &&
+		     trellis_map_patch (o, image, &r);
+
+	if (!ok)
+		goto error;
+
+	if (!bitmap_export (image, out)) {
+		chip_error (&o->conf, "cannot export bitmap to %s: %s",
+			    out, strerror (errno));
+		goto error;
+	}
+
+	ok = trellis_map_save (o, state, out, image);
+
+	bitmap_free (image);
+	array_free (r.rect, r.count, NULL);
+	trellis_state_fini (&s);
+	return ok;
+no_image:
+	chip_error (&o->conf, NULL);
+error:
+	bitmap_free (image);
+	array_free (r.rect, r.count, NULL);
+	trellis_state_fini (&s);
+	return 0;
+}
+
+const char *trellis_map_family (const struct trellis_map *o)
+{
+	return o->family;
+}
+
+const char *trellis_map_error (const struct trellis_map *o)
+{
+	return o->conf.error;
+}
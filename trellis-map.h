@@ -0,0 +1,32 @@
+/*
+ * Trellis Design Map
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TRELLIS_MAP_H
+#define TRELLIS_MAP_H  1
+
+/*
+ * Mapper keeps databases of chip family and resolved tiles between designs,
+ * thus the cost of setup paid once for all designs mapped with it.
+ */
+struct trellis_map *trellis_map_alloc (const char *family);
+void trellis_map_free (struct trellis_map *o);
+
+int trellis_map (struct trellis_map *o, const char *in, const char *out);
+
+/*
+ * Map design reusing previous image: only tiles changed since the run
+ * recorded in the state file are resolved and written over the image.
+ * Falls back to full map if there is no valid state or image.
+ */
+int trellis_remap (struct trellis_map *o, const char *in, const char *out,
+		   const char *state);
+
+const char *trellis_map_family (const struct trellis_map *o);
+const char *trellis_map_error  (const struct trellis_map *o);
+
+#endif  /* TRELLIS_MAP_H */
@@ -0,0 +1,228 @@
+/*
+ * Trellis Design Map State
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dakota/data/array.h>
+#include <dakota/data/hash.h>
+
+#include "trellis-state.h"
+
+#define STATE_MAGIC	"trellis-map-state"
+#define STATE_VERSION	2
+
+void trellis_state_init (struct trellis_state *o)
+{
+	o->family    = NULL;
+	o->device    = NULL;
+	o->width     = 0;
+	o->height    = 0;
+	o->image     = 0;
+	o->nblocks   = 0;
+	o->maxblocks = 0;
+	o->block     = NULL;
+	o->order     = 0;
+	o->index     = NULL;
+}
+
+static void block_fini (struct trellis_block *o)
+{
+	free (o->key);
+}
+
+void trellis_state_fini (struct trellis_state *o)
+{
+	free (o->family);
+	free (o->device);
+	array_free (o->block, o->nblocks, block_fini);
+	free (o->index);
+
+	trellis_state_init (o);
+}
+
+int trellis_state_set (struct trellis_state *o, const char *family,
+		       const char *device, size_t width, size_t height)
+{
+	char *f, *d;
+
+	if ((f = strdup (family)) == NULL)
+		return 0;
+
+	if ((d = strdup (device)) == NULL)
+		goto no_device;
+
+	free (o->family);
+	free (o->device);
+
+	o->family = f;
+	o->device = d;
+	o->width  = width;
+	o->height = height;
+	return 1;
+no_device:
+	free (f);
+	return 0;
+}
+
+int trellis_state_add (struct trellis_state *o, const char *key,
+		       uint64_t hash, size_t x, size_t y, size_t w, size_t h)
+{
+	const size_t nblocks = o->nblocks + 1;
+	struct trellis_block *p;
+
+	if ((p = array_grow (o->block, o->maxblocks, nblocks)) == NULL)
+		return 0;
+
+	o->block = p;
+	p += o->nblocks;
+
+	free (o->index);  /* drop stale index */
+	o->order = 0;
+	o->index = NULL;
+
+	if ((p->key = strdup (key)) == NULL)
+		return 0;
+
+	p->hash = hash;
+	p->x    = x;
+	p->y    = y;
+	p->w    = w;
+	p->h    = h;
+
+	o->nblocks = nblocks;
+	return 1;
+}
+
+/*
+ * Open addressing index of blocks by key, built on demand and filled not
+ * more than a half
+ */
+static int trellis_state_index (struct trellis_state *o)
+{
+	size_t order, size, mask, i, pos;
+	size_t *index;
+
+	if (o->index != NULL)
+		return 1;
+
+	for (order = 4; ((size_t) 1 << (order - 1)) <= o->nblocks; ++order) {}
+
+	size = (size_t) 1 << order;
+	mask = size - 1;
+
+	if ((index = calloc (size, sizeof (index[0]))) == NULL)
+		return 0;
+
+	for (i = 0; i < o->nblocks; ++i) {
+		pos = hash_string (HASH_INIT, o->block[i].key) & mask;
+
+		for (; index[pos] != 0; pos = (pos + 1) & mask) {}
+
+		index[pos] = i + 1;
+	}
+
+	o->order = order;
+	o->index = index;
+	return 1;
+}
+
+size_t trellis_state_find (struct trellis_state *o, const char *key)
+{
+	size_t mask, pos, i;
+
+	if (!trellis_state_index (o))
+		return TS_UNKNOWN;
+
+	mask = ((size_t) 1 << o->order) - 1;
+	pos  = hash_string (HASH_INIT, key) & mask;
+
+	for (; (i = o->index[pos]) != 0; pos = (pos + 1) & mask)
+		if (strcmp (o->block[i - 1].key, key) == 0)
+			return i - 1;
+
+	return TS_UNKNOWN;
+}
+
+static int read_block (struct trellis_state *o, FILE *in)
+{
+	uint64_t hash;
+	size_t x, y, w, h;
+	char *key;
+	int ok;
+
+	if (fscanf (in, "%" SCNx64 " %zu %zu %zu %zu %ms",
+		    &hash, &x, &y, &w, &h, &key) != 6)
+		return 0;
+
+	ok = trellis_state_add (o, key, hash, x, y, w, h);
+	free (key);
+	return ok;
+}
+
+int trellis_state_read (struct trellis_state *o, const char *path)
+{
+	FILE *in;
+	char verb[16];
+	unsigned version;
+	int ok;
+
+	trellis_state_fini (o);
+
+	if ((in = fopen (path, "r")) == NULL)
+		return 0;
+
+	ok = fscanf (in, STATE_MAGIC " %u", &version) == 1 &&
+	     version == STATE_VERSION &&
+	     fscanf (in, " family %ms device %ms size %zu %zu image %" SCNx64,
+		     &o->family, &o->device, &o->width, &o->height,
+		     &o->image) == 5;
+
+	while (ok && fscanf (in, "%15s", verb) == 1)
+		ok = strcmp (verb, "block") == 0 && read_block (o, in);
+
+	ok &= !ferror (in);
+	fclose (in);
+
+	if (ok)
+		return 1;
+
+	trellis_state_fini (o);
+	errno = EILSEQ;
+	return 0;
+}
+
+int trellis_state_write (const struct trellis_state *o, const char *path)
+{
+	FILE *out;
+	const struct trellis_block *b;
+	size_t i;
+	int ok;
+
+	if ((out = fopen (path, "w")) == NULL)
+		return 0;
+
+	ok = fprintf (out, STATE_MAGIC " %u\nfamily %s\ndevice %s\n"
+		      "size %zu %zu\nimage %016" PRIx64 "\n", STATE_VERSION,
+		      o->family, o->device, o->width, o->height,
+		      o->image) > 0;
+
+	for (i = 0, b = o->block; ok && i < o->nblocks; ++i, ++b)
+		ok = fprintf (out, "block %016" PRIx64 " %zu %zu %zu %zu %s\n",
+			      b->hash, b->x, b->y, b->w, b->h, b->key) > 0;
+
+	ok &= fclose (out) == 0;
+
+	if (!ok)
+		remove (path);
+
+	return ok;
+}
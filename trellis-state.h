@@ -0,0 +1,54 @@
+/*
+ * Trellis Design Map State
+ *
+ * Copyright (c) 2021 Alexei A. Smekalkine <ikle@ikle.ru>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#ifndef TRELLIS_STATE_H
+#define TRELLIS_STATE_H  1
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Map state remembers content hash of every tile block of the design and
+ * the rectangle of image touched by this block. Block is identified by
+ * the name of its first tile. Content hash of the written image file is
+ * kept to detect image changed behind our back.
+ */
+struct trellis_block {
+	char *key;
+	uint64_t hash;
+	size_t x, y, w, h;
+};
+
+struct trellis_state {
+	char *family, *device;
+	size_t width, height;
+	uint64_t image;		/* hash of image file */
+
+	size_t nblocks, maxblocks;
+	struct trellis_block *block;
+
+	size_t order;		/* log2 of index size */
+	size_t *index;		/* block number + 1 or zero if unused */
+};
+
+void trellis_state_init (struct trellis_state *o);
+void trellis_state_fini (struct trellis_state *o);
+
+int trellis_state_set (struct trellis_state *o, const char *family,
+		       const char *device, size_t width, size_t height);
+int trellis_state_add (struct trellis_state *o, const char *key,
+		       uint64_t hash, size_t x, size_t y, size_t w, size_t h);
+
+#define TS_UNKNOWN  ((size_t) -1)
+
+size_t trellis_state_find (struct trellis_state *o, const char *key);
+
+int trellis_state_read  (struct trellis_state *o, const char *path);
+int trellis_state_write (const struct trellis_state *o, const char *path);
+
+#endif  /* TRELLIS_STATE_H */
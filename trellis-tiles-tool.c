@@ -258,7 +258,7 @@ int main (int argc, char *argv[])
 	if (!ok)
 		errx (1, c.error);
 
-	if (!cmdb_close (o.db))
+	if (!dakota_close (o.db))
 		errx (1, "cannot commit to database");
 
 	return 0;